@@ -0,0 +1,62 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../bitbang_io.h"
+
+// Bit-banged SPI on mprj_io 8 (SCK), 9 (MOSI), 10 (MISO), 11 (CS) and
+// I2C on mprj_io 12 (SCL), 13 (SDA).  Prints the bit rate achieved in
+// each SPI mode at full speed, with a calibrated 100 kHz clock, and for
+// I2C writes.
+
+#define LEN 64
+
+static uint8_t buf[LEN];
+
+static void report(const char *name, uint32_t bits, uint32_t cycles)
+{
+    print_fmt("%-12s %6u bits %9u cycles %8u bit/s\n",
+              name, bits, cycles, time_rate(bits, cycles));
+}
+
+void main()
+{
+    bb_spi_t spi;
+    bb_i2c_t i2c;
+    uint32_t start;
+    char name[] = "spi mode 0";
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    for (int i = 0; i < LEN; i++)
+        buf[i] = 0x5a ^ i;
+
+    print("bitbang_bench\n");
+    bb_sync();
+
+    for (uint32_t mode = 0; mode < 4; mode++) {
+        bb_spi_init(&spi, 8, 9, 10, 11, mode, 0);
+        start = time_cycles();
+        bb_spi_select(&spi);
+        bb_spi_write(&spi, buf, LEN);
+        bb_spi_deselect(&spi);
+        name[9] = '0' + mode;
+        report(name, LEN << 3, time_elapsed(start));
+    }
+
+    bb_spi_init(&spi, 8, 9, 10, 11, 0, 100000);
+    start = time_cycles();
+    bb_spi_select(&spi);
+    bb_spi_write(&spi, buf, LEN);
+    bb_spi_deselect(&spi);
+    report("spi 100 kHz", LEN << 3, time_elapsed(start));
+
+    bb_i2c_init(&i2c, 12, 13, 0);
+    start = time_cycles();
+    bb_i2c_start(&i2c);
+    for (int i = 0; i < 16; i++)
+        bb_i2c_write(&i2c, buf[i]);
+    bb_i2c_stop(&i2c);
+    report("i2c write", 16 * 9, time_elapsed(start));
+}
@@ -0,0 +1,323 @@
+#include "bitbang_io.h"
+#include "time_io.h"
+
+// Shadows of reg_mprj_datal and reg_mprj_datah.  Every edge is a single
+// store of a precomputed value; the data registers are never read back
+// except to sample an input pin.
+static uint32_t bb_shadow[2];
+
+static volatile uint32_t *bb_port(uint32_t pin, uint32_t **shadow)
+{
+    if (pin < 32) {
+        *shadow = &bb_shadow[0];
+        return &reg_mprj_datal;
+    }
+    *shadow = &bb_shadow[1];
+    return &reg_mprj_datah;
+}
+
+static void bb_pad(uint32_t pin, uint32_t mode)
+{
+    (&reg_mprj_io_0)[pin] = mode;
+    reg_mprj_xfer = 1;
+    while (reg_mprj_xfer == 1);
+}
+
+/*
+ * bb_sync()
+ * ----------------------------------------------------------------------------
+ * reload the shadows after other code wrote reg_mprj_datal/datah
+ */
+void bb_sync()
+{
+    bb_shadow[0] = reg_mprj_datal;
+    bb_shadow[1] = reg_mprj_datah;
+}
+
+/*
+ * bb_pin_set()
+ * ----------------------------------------------------------------------------
+ * drive one pin high or low through the shadow
+ */
+void bb_pin_set(uint32_t pin, uint32_t value)
+{
+    uint32_t *shadow;
+    volatile uint32_t *data = bb_port(pin, &shadow);
+    uint32_t mask = 1 << (pin & 31);
+
+    *shadow = value ? (*shadow | mask) : (*shadow & ~mask);
+    *data = *shadow;
+}
+
+// ============================================================================
+// SPI
+// ============================================================================
+// One bit is two stores.  CPHA = 0: data is set with SCK idle, sampled on
+// the leading edge, and the trailing edge is merged into the next bit's
+// data store.  CPHA = 1: data changes on the leading edge and is sampled
+// just before the trailing edge.  The 8 bits of a byte are unrolled.
+
+#define BB_SPI_BIT0(bit, wait)						\
+    v = lo | (((data >> (bit)) & 1) << bb->mosi_shift);			\
+    *d = v;								\
+    wait;								\
+    *d = v ^ sck;							\
+    rx = (rx << 1) | ((*d >> bb->miso_shift) & 1);			\
+    wait;
+
+#define BB_SPI_BIT1(bit, wait)						\
+    v = lo | (((data >> (bit)) & 1) << bb->mosi_shift);			\
+    *d = v ^ sck;							\
+    wait;								\
+    rx = (rx << 1) | ((*d >> bb->miso_shift) & 1);			\
+    *d = v;								\
+    wait;
+
+#define BB_SPI_BYTE(name, wait)						\
+static uint32_t name(bb_spi_t *bb, uint32_t data)			\
+{									\
+    volatile uint32_t *d = bb->data;					\
+    uint32_t sck = bb->sck;						\
+    uint32_t lo = (*bb->shadow & ~(sck | bb->mosi)) | (bb->cpol ? sck : 0); \
+    uint32_t v = lo, rx = 0;						\
+									\
+    if (bb->cpha) {							\
+        BB_SPI_BIT1(7, wait) BB_SPI_BIT1(6, wait)			\
+        BB_SPI_BIT1(5, wait) BB_SPI_BIT1(4, wait)			\
+        BB_SPI_BIT1(3, wait) BB_SPI_BIT1(2, wait)			\
+        BB_SPI_BIT1(1, wait) BB_SPI_BIT1(0, wait)			\
+    } else {								\
+        BB_SPI_BIT0(7, wait) BB_SPI_BIT0(6, wait)			\
+        BB_SPI_BIT0(5, wait) BB_SPI_BIT0(4, wait)			\
+        BB_SPI_BIT0(3, wait) BB_SPI_BIT0(2, wait)			\
+        BB_SPI_BIT0(1, wait) BB_SPI_BIT0(0, wait)			\
+        *d = v;								\
+    }									\
+    *bb->shadow = v;							\
+    return rx;								\
+}
+
+BB_SPI_BYTE(bb_spi_byte_fast, )
+BB_SPI_BYTE(bb_spi_byte_timed, delay_cycles(bb->half))
+
+/*
+ * bb_spi_init()
+ * ----------------------------------------------------------------------------
+ * set up a bit-banged SPI bus on the given pads (cs may be 0xff for none),
+ * mode 0-3 (CPOL = bit 1, CPHA = bit 0), clock rate hz (0 = as fast as the
+ * core can toggle).  The half-bit delay is calibrated against the measured
+ * cost of the transfer loop.  Returns -1 if the pins are not all on one
+ * data register.
+ */
+int bb_spi_init(bb_spi_t *bb, uint32_t sck, uint32_t mosi, uint32_t miso,
+                uint32_t cs, uint32_t mode, uint32_t hz)
+{
+    uint32_t hi = sck >> 5;
+
+    if ((mosi >> 5) != hi || (miso >> 5) != hi || (cs != 0xff && (cs >> 5) != hi))
+        return -1;
+
+    bb->data = bb_port(sck, &bb->shadow);
+    bb->sck = 1 << (sck & 31);
+    bb->mosi = 1 << (mosi & 31);
+    bb->cs = cs != 0xff ? 1 << (cs & 31) : 0;
+    bb->mosi_shift = mosi & 31;
+    bb->miso_shift = miso & 31;
+    bb->cpol = (mode >> 1) & 1;
+    bb->cpha = mode & 1;
+    bb->half = 0;
+
+    bb_pad(sck, GPIO_MODE_MGMT_STD_OUTPUT);
+    bb_pad(mosi, GPIO_MODE_MGMT_STD_OUTPUT);
+    bb_pad(miso, GPIO_MODE_MGMT_STD_INPUT_NOPULL);
+    if (bb->cs)
+        bb_pad(cs, GPIO_MODE_MGMT_STD_OUTPUT);
+
+    // Idle: CS high, SCK at CPOL
+    *bb->shadow |= bb->cs;
+    *bb->shadow = (*bb->shadow & ~bb->sck) | (bb->cpol ? bb->sck : 0);
+    *bb->data = *bb->shadow;
+
+    if (hz) {
+        // Time one byte (16 half bits) with the shortest delay, with CS
+        // high so no device sees it, and pad each half bit to the target
+        uint32_t half = time_period_cycles(hz) >> 1;
+        uint32_t start, loop;
+
+        bb->half = 1;
+        start = time_cycles();
+        bb_spi_byte_timed(bb, 0);
+        loop = time_elapsed(start) >> 4;
+        bb->half = half > loop ? half - loop + 1 : 1;
+    }
+    return 0;
+}
+
+void bb_spi_select(bb_spi_t *bb)
+{
+    *bb->shadow &= ~bb->cs;
+    *bb->data = *bb->shadow;
+}
+
+void bb_spi_deselect(bb_spi_t *bb)
+{
+    *bb->shadow |= bb->cs;
+    *bb->data = *bb->shadow;
+}
+
+uint32_t bb_spi_xfer(bb_spi_t *bb, uint32_t data)
+{
+    return bb->half ? bb_spi_byte_timed(bb, data) : bb_spi_byte_fast(bb, data);
+}
+
+void bb_spi_write(bb_spi_t *bb, const uint8_t *buf, int len)
+{
+    if (bb->half) {
+        for (int i = 0; i < len; i++)
+            bb_spi_byte_timed(bb, buf[i]);
+    } else {
+        for (int i = 0; i < len; i++)
+            bb_spi_byte_fast(bb, buf[i]);
+    }
+}
+
+void bb_spi_transfer(bb_spi_t *bb, const uint8_t *tx, uint8_t *rx, int len)
+{
+    for (int i = 0; i < len; i++)
+        rx[i] = bb_spi_xfer(bb, tx[i]);
+}
+// ============================================================================
+
+
+// ============================================================================
+// I2C
+// ============================================================================
+// Management pads have no per-pin output enable register, so SDA is
+// released by switching its pad to input with pull-up (one configuration
+// transfer) for the ACK bit and for reads, and driven push-pull otherwise.
+// SCL is push-pull: single master, no clock stretching.
+
+static void bb_i2c_wait(bb_i2c_t *bb)
+{
+    if (bb->half)
+        delay_cycles(bb->half);
+}
+
+static void bb_i2c_set(bb_i2c_t *bb, uint32_t mask, uint32_t value)
+{
+    *bb->shadow = value ? (*bb->shadow | mask) : (*bb->shadow & ~mask);
+    *bb->data = *bb->shadow;
+}
+
+static void bb_i2c_release(bb_i2c_t *bb)
+{
+    bb_pad(bb->sda_pad, GPIO_MODE_MGMT_STD_INPUT_PULLUP);
+}
+
+static void bb_i2c_drive(bb_i2c_t *bb)
+{
+    bb_pad(bb->sda_pad, GPIO_MODE_MGMT_STD_OUTPUT);
+}
+
+/*
+ * bb_i2c_init()
+ * ----------------------------------------------------------------------------
+ * set up an I2C bus on pads scl and sda at about hz (0 = full speed);
+ * returns -1 if the pins are not on one data register
+ */
+int bb_i2c_init(bb_i2c_t *bb, uint32_t scl, uint32_t sda, uint32_t hz)
+{
+    if ((scl >> 5) != (sda >> 5))
+        return -1;
+
+    bb->data = bb_port(scl, &bb->shadow);
+    bb->scl = 1 << (scl & 31);
+    bb->sda = 1 << (sda & 31);
+    bb->sda_shift = sda & 31;
+    bb->sda_pad = sda;
+    bb->half = time_period_cycles(hz) >> 1;
+
+    *bb->shadow |= bb->scl | bb->sda;
+    *bb->data = *bb->shadow;
+    bb_pad(scl, GPIO_MODE_MGMT_STD_OUTPUT);
+    bb_pad(sda, GPIO_MODE_MGMT_STD_OUTPUT);
+    return 0;
+}
+
+void bb_i2c_start(bb_i2c_t *bb)
+{
+    bb_i2c_set(bb, bb->sda, 1);
+    bb_i2c_set(bb, bb->scl, 1);
+    bb_i2c_wait(bb);
+    bb_i2c_set(bb, bb->sda, 0);
+    bb_i2c_wait(bb);
+    bb_i2c_set(bb, bb->scl, 0);
+}
+
+void bb_i2c_stop(bb_i2c_t *bb)
+{
+    bb_i2c_set(bb, bb->sda, 0);
+    bb_i2c_wait(bb);
+    bb_i2c_set(bb, bb->scl, 1);
+    bb_i2c_wait(bb);
+    bb_i2c_set(bb, bb->sda, 1);
+    bb_i2c_wait(bb);
+}
+
+/*
+ * bb_i2c_write()
+ * ----------------------------------------------------------------------------
+ * send one byte, returns 1 if the device acknowledged it
+ */
+int bb_i2c_write(bb_i2c_t *bb, uint32_t data)
+{
+    volatile uint32_t *d = bb->data;
+    uint32_t lo = *bb->shadow & ~(bb->scl | bb->sda);
+    uint32_t v;
+    int ack;
+
+    for (int i = 7; i >= 0; i--) {
+        v = lo | (((data >> i) & 1) << bb->sda_shift);
+        *d = v;
+        bb_i2c_wait(bb);
+        *d = v | bb->scl;
+        bb_i2c_wait(bb);
+        *d = v;
+    }
+    *bb->shadow = v;
+
+    bb_i2c_release(bb);
+    bb_i2c_set(bb, bb->scl, 1);
+    bb_i2c_wait(bb);
+    ack = !((*d >> bb->sda_shift) & 1);
+    bb_i2c_set(bb, bb->scl, 0);
+    bb_i2c_drive(bb);
+    return ack;
+}
+
+/*
+ * bb_i2c_read()
+ * ----------------------------------------------------------------------------
+ * read one byte, then acknowledge it (ack = 1) or not (last byte)
+ */
+uint32_t bb_i2c_read(bb_i2c_t *bb, int ack)
+{
+    volatile uint32_t *d = bb->data;
+    uint32_t data = 0;
+
+    bb_i2c_release(bb);
+    for (int i = 0; i < 8; i++) {
+        bb_i2c_set(bb, bb->scl, 1);
+        bb_i2c_wait(bb);
+        data = (data << 1) | ((*d >> bb->sda_shift) & 1);
+        bb_i2c_set(bb, bb->scl, 0);
+        bb_i2c_wait(bb);
+    }
+    bb_i2c_set(bb, bb->sda, !ack);
+    bb_i2c_drive(bb);
+    bb_i2c_set(bb, bb->scl, 1);
+    bb_i2c_wait(bb);
+    bb_i2c_set(bb, bb->scl, 0);
+    return data;
+}
+// ============================================================================
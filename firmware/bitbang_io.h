@@ -0,0 +1,52 @@
+#ifndef BITBANG_IO_H
+#define BITBANG_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Bit-bang protocol engine for management-controlled user area pads
+// (mprj_io 0-31 on reg_mprj_datal, 32-37 on reg_mprj_datah).  All pins of
+// one bus must be on the same data register.  Outputs are written from a
+// shadow of the data register, so other code that writes the same register
+// directly must call bb_sync() afterwards.
+
+typedef struct {
+    volatile uint32_t *data;	// &reg_mprj_datal or &reg_mprj_datah
+    uint32_t *shadow;
+    uint32_t sck;		// pin masks
+    uint32_t mosi;
+    uint32_t cs;
+    uint32_t mosi_shift;	// MOSI and MISO bit positions
+    uint32_t miso_shift;
+    uint32_t cpol;
+    uint32_t cpha;
+    uint32_t half;		// extra cycles per half bit (0 = full speed)
+} bb_spi_t;
+
+typedef struct {
+    volatile uint32_t *data;
+    uint32_t *shadow;
+    uint32_t scl;
+    uint32_t sda;
+    uint32_t sda_shift;
+    uint32_t sda_pad;
+    uint32_t half;
+} bb_i2c_t;
+
+void bb_sync();
+void bb_pin_set(uint32_t pin, uint32_t value);
+
+int bb_spi_init(bb_spi_t *bb, uint32_t sck, uint32_t mosi, uint32_t miso,
+                uint32_t cs, uint32_t mode, uint32_t hz);
+void bb_spi_select(bb_spi_t *bb);
+void bb_spi_deselect(bb_spi_t *bb);
+uint32_t bb_spi_xfer(bb_spi_t *bb, uint32_t data);
+void bb_spi_write(bb_spi_t *bb, const uint8_t *buf, int len);
+void bb_spi_transfer(bb_spi_t *bb, const uint8_t *tx, uint8_t *rx, int len);
+
+int bb_i2c_init(bb_i2c_t *bb, uint32_t scl, uint32_t sda, uint32_t hz);
+void bb_i2c_start(bb_i2c_t *bb);
+void bb_i2c_stop(bb_i2c_t *bb);
+int bb_i2c_write(bb_i2c_t *bb, uint32_t data);
+uint32_t bb_i2c_read(bb_i2c_t *bb, int ack);
+
+#endif // BITBANG_IO_H
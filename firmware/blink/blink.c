@@ -1,5 +1,6 @@
 //#include "../defs.h"
 #include "../defs_mpw-two-mfix.h"
+#include "../time_io.h"
 
 // --------------------------------------------------------
 // Firmware routines
@@ -7,7 +8,7 @@
 
 void main()
 {
-	int i, j;
+	int i;
 
 	i = 1;
 
@@ -71,13 +72,13 @@ void main()
         reg_gpio_data = 0x0;
 //        reg_mprj_datal = 0x00000000;
 //        reg_mprj_datah = 0x00000000;
-        for (j = 0; j < 3000; j++);
+        delay_ms(150);
 
         reg_gpio_data = 0x1;
 //        reg_mprj_datal = 0xffff0000;
 //        reg_mprj_datal = 0xffffff00;
 //        reg_mprj_datah = 0xffffffff;
-        for (j = 0; j < 3000; j++);
+        delay_ms(150);
 	}
 
 }
@@ -0,0 +1,237 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../ramfunc.h"
+
+// Load and store cost per address region of the management SoC:
+//
+//   latency    cycles of one lw or sw between two rdcycle reads, less the
+//              cost of the rdcycle itself; minimum over RUNS tries
+//   bandwidth  cycles per word of an unrolled loop of 8 lw (or sw) and a
+//              pointer and count update, streaming over a WINDOW_WORDS
+//              window ROUNDS times (the loop overhead is included)
+//
+// Everything that is timed runs from RAM, so instruction fetches do not
+// queue behind flash data reads.  The peripheral region is the user pad
+// configuration block (reg_mprj_io_0..): its registers only reach the pads
+// on a reg_mprj_xfer, so the window is saved before the stores and
+// restored after them.
+//
+// The user project must acknowledge wishbone cycles at 0x3000_0000 (the
+// simulator's default user model is plain memory);  build with
+// -DBUS_NO_USER to leave it out.
+//
+// Results are printed as a table and as one "bus" line per region:
+//
+//   bus <region> <rd lat> <wr lat> <rd words> <rd cycles> <wr words> <wr cycles>
+//
+// with "-" for an access the region does not take.
+
+#define RUNS		8
+#define WINDOW_LOG2	4
+#define WINDOW_WORDS	(1 << WINDOW_LOG2)
+#define ROUNDS_LOG2	5
+#define ROUNDS		(1 << ROUNDS_LOG2)
+#define WORDS_LOG2	(WINDOW_LOG2 + ROUNDS_LOG2)
+
+#define FLASH_XIP	((volatile uint32_t *) 0x10000000)
+
+#define BUS_WRITE	0x1	// region takes stores
+#define BUS_RESTORE	0x2	// put the window back after the stores
+
+typedef struct {
+    const char *name;
+    volatile uint32_t *base;
+    uint32_t flags;
+} bus_region_t;
+
+typedef struct {
+    uint32_t rd_lat, wr_lat;
+    uint32_t rd_cycles, wr_cycles;
+} bus_result_t;
+
+static uint32_t ram_window[WINDOW_WORDS];
+
+static const bus_region_t regions[] = {
+    {"ram",       ram_window,        BUS_WRITE},
+    {"rw_block1", &reg_rw_block1,    BUS_WRITE},
+    {"ro_block0", &reg_ro_block0,    0},
+    {"periph",    &reg_mprj_io_0,    BUS_WRITE | BUS_RESTORE},
+#ifndef BUS_NO_USER
+    {"user_wb",   &reg_mprj_slave,   BUS_WRITE},
+#endif
+    {"flash",     FLASH_XIP,         0},
+};
+
+#define REGIONS		(sizeof(regions) / sizeof(regions[0]))
+
+// ---- Single accesses ----
+
+RAMFUNC static uint32_t lat_none(void)
+{
+    uint32_t t0, t1;
+
+    __asm__ volatile ("rdcycle %0\n\trdcycle %1" : "=&r"(t0), "=&r"(t1));
+    return t1 - t0;
+}
+
+RAMFUNC static uint32_t lat_read(volatile uint32_t *p)
+{
+    uint32_t t0, t1, v;
+
+    __asm__ volatile ("rdcycle %0\n\tlw %2, 0(%3)\n\trdcycle %1"
+                      : "=&r"(t0), "=&r"(t1), "=&r"(v) : "r"(p) : "memory");
+    return t1 - t0;
+}
+
+RAMFUNC static uint32_t lat_write(volatile uint32_t *p)
+{
+    uint32_t t0, t1;
+
+    __asm__ volatile ("rdcycle %0\n\tsw zero, 0(%2)\n\trdcycle %1"
+                      : "=&r"(t0), "=&r"(t1) : "r"(p) : "memory");
+    return t1 - t0;
+}
+
+// ---- Unrolled streams ----
+
+// 8 consecutive words from %3 on, then advance %3 past them
+#define BUS_ACCESS8(insn)						\
+    insn " %2, 0(%3)\n\t"  insn " %2, 4(%3)\n\t"				\
+    insn " %2, 8(%3)\n\t"  insn " %2, 12(%3)\n\t"				\
+    insn " %2, 16(%3)\n\t" insn " %2, 20(%3)\n\t"				\
+    insn " %2, 24(%3)\n\t" insn " %2, 28(%3)\n\t"				\
+    "addi %3, %3, 32\n\t"
+
+// cycles for 8 * n accesses
+#define BUS_STREAM(name, insn)						\
+RAMFUNC static uint32_t name(volatile uint32_t *p, uint32_t n)		\
+{									\
+    uint32_t t0, t1, v = 0;						\
+									\
+    __asm__ volatile ("rdcycle %0\n"					\
+                      "1:\n\t"						\
+                      BUS_ACCESS8(insn)					\
+                      "addi %4, %4, -1\n\t"				\
+                      "bnez %4, 1b\n\t"					\
+                      "rdcycle %1"					\
+                      : "=&r"(t0), "=&r"(t1), "+r"(v), "+r"(p), "+r"(n)	\
+                      : : "memory");					\
+    return t1 - t0;							\
+}
+
+BUS_STREAM(stream_read, "lw")
+BUS_STREAM(stream_write, "sw")
+
+static uint32_t lat_min(const bus_region_t *r, int write, uint32_t base)
+{
+    uint32_t best = 0xffffffff, t;
+
+    for (int i = 0; i < RUNS; i++) {
+        t = (write ? lat_write(r->base) : lat_read(r->base)) - base;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+static uint32_t stream(const bus_region_t *r, int write)
+{
+    uint32_t cycles = 0;
+
+    for (int i = 0; i < ROUNDS; i++)
+        cycles += write ? stream_write(r->base, WINDOW_WORDS >> 3)
+                        : stream_read(r->base, WINDOW_WORDS >> 3);
+    return cycles;
+}
+
+// cycles per word as a right-aligned column, or "-"
+static void print_cpw(uint32_t cycles, int valid)
+{
+    char buf[FMT_U32_LEN + 4];
+    int n;
+
+    if (!valid) {
+        print_fmt(" %9s", "-");
+        return;
+    }
+    n = fmt_fixed(buf, cycles, WORDS_LOG2, 2);
+    buf[n] = 0;
+    print_fmt(" %9s", buf);
+}
+
+static void print_cell(uint32_t v, int valid)
+{
+    if (valid)
+        print_fmt(" %u", v);
+    else
+        print(" -");
+}
+
+void main()
+{
+    bus_result_t res[REGIONS];
+    uint32_t saved[WINDOW_WORDS];
+    const bus_region_t *r;
+    uint32_t base = 0xffffffff, t;
+    int w;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("bus_bench\n");
+
+    // cost of the rdcycle that closes a latency measurement
+    for (int i = 0; i < RUNS; i++) {
+        t = lat_none();
+        if (t < base)
+            base = t;
+    }
+
+    for (uint32_t i = 0; i < REGIONS; i++) {
+        r = &regions[i];
+        res[i].rd_lat = lat_min(r, 0, base);
+        res[i].rd_cycles = stream(r, 0);
+        if (!(r->flags & BUS_WRITE))
+            continue;
+        if (r->flags & BUS_RESTORE)
+            for (int k = 0; k < WINDOW_WORDS; k++)
+                saved[k] = r->base[k];
+        res[i].wr_lat = lat_min(r, 1, base);
+        res[i].wr_cycles = stream(r, 1);
+        if (r->flags & BUS_RESTORE)
+            for (int k = 0; k < WINDOW_WORDS; k++)
+                r->base[k] = saved[k];
+    }
+
+    print_fmt("%-10s %6s %6s %9s %9s %10s %10s\n", "region", "rd lat", "wr lat",
+              "rd cyc/w", "wr cyc/w", "rd B/s", "wr B/s");
+    for (uint32_t i = 0; i < REGIONS; i++) {
+        r = &regions[i];
+        w = r->flags & BUS_WRITE;
+        print_fmt("%-10s %6u", r->name, res[i].rd_lat);
+        if (w)
+            print_fmt(" %6u", res[i].wr_lat);
+        else
+            print_fmt(" %6s", "-");
+        print_cpw(res[i].rd_cycles, 1);
+        print_cpw(res[i].wr_cycles, w);
+        print_fmt(" %10u", time_rate(WINDOW_WORDS << (ROUNDS_LOG2 + 2), res[i].rd_cycles));
+        if (w)
+            print_fmt(" %10u\n", time_rate(WINDOW_WORDS << (ROUNDS_LOG2 + 2), res[i].wr_cycles));
+        else
+            print_fmt(" %10s\n", "-");
+    }
+
+    for (uint32_t i = 0; i < REGIONS; i++) {
+        r = &regions[i];
+        w = r->flags & BUS_WRITE;
+        print_fmt("bus %s %u", r->name, res[i].rd_lat);
+        print_cell(res[i].wr_lat, w);
+        print_fmt(" %u %u", 1 << WORDS_LOG2, res[i].rd_cycles);
+        print_cell(1 << WORDS_LOG2, w);
+        print_cell(res[i].wr_cycles, w);
+        print("\n");
+    }
+}
@@ -0,0 +1,82 @@
+# SPDX-FileCopyrightText: 2020 Efabless Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# ---- Build profiles ----
+#
+# Included at the end of a firmware Makefile, after it sets
+#
+#   PATTERN       the firmware name (<PATTERN>.c)
+#   SOURCES       the shared sources linked in (start.s first)
+#   SIM_FLAGS     caravel_iss.py options for "make sim" (optional)
+#   MATRIX_FUNCS  functions whose cycles "make matrix" lists (optional)
+#
+# A profile is <opt>-<isa>[-lto]:  opt is O0, Os or O2, isa is i (rv32i)
+# or imc (rv32imc, compressed instructions and hardware multiply/divide).
+# O0-i is the default build made by the Makefile's own %.elf rule.
+#
+#   make profile-Os-imc   build/Os-imc/<PATTERN>.elf
+#   make profiles         every profile
+#   make matrix           flash, RAM and simulated cycles of every profile
+
+TOOLCHAIN_PREFIX ?= riscv32
+PROFILE_GCC = $(TOOLCHAIN_PATH)$(TOOLCHAIN_PREFIX)-unknown-elf-gcc
+PROFILE_OBJDUMP = $(TOOLCHAIN_PATH)$(TOOLCHAIN_PREFIX)-unknown-elf-objdump
+
+PROFILES = $(foreach opt,O0 Os O2,$(foreach isa,i imc,$(opt)-$(isa) $(opt)-$(isa)-lto))
+
+profile_words = $(subst -, ,$(1))
+profile_flags = -$(word 1,$(call profile_words,$(1))) \
+	-march=rv32$(word 2,$(call profile_words,$(1))) -mabi=ilp32 \
+	$(if $(filter lto,$(call profile_words,$(1))),-flto)
+
+# gcc may turn loops into memcpy/memset calls; keep the loops as written so
+# profiles time the same code.  runtime.s (in SOURCES) supplies memcpy,
+# memset and 32-bit multiply/divide, libgcc anything else
+PROFILE_CFLAGS = -ffreestanding -nostdlib -fno-tree-loop-distribute-patterns \
+	-Wl,-Bstatic,-T,../sections.lds,--strip-debug
+
+MATRIX_CYCLES ?= 50000000
+
+build/%/$(PATTERN).elf: $(PATTERN).c $(SOURCES) ../sections.lds
+	mkdir -p $(dir $@)
+	$(PROFILE_GCC) $(call profile_flags,$*) $(PROFILE_CFLAGS) -o $@ $(SOURCES) $< -lgcc
+
+profile-%: build/%/$(PATTERN).elf
+	@true
+
+.PRECIOUS: build/%/$(PATTERN).elf
+
+profiles: $(PROFILES:%=profile-%)
+
+matrix:
+	-$(MAKE) -k profiles
+	mkdir -p build
+	python3 ../util/profile_matrix.py --objdump $(PROFILE_OBJDUMP) \
+		--max-cycles $(MATRIX_CYCLES) --sim-flags "$(SIM_FLAGS)" \
+		--funcs "$(MATRIX_FUNCS)" --out build/matrix.txt \
+		$(PATTERN) $(PROFILES)
+
+.PHONY: profiles matrix
+
+# ---- Memory budget ----
+#
+# Write the figures of the default build as its limits in mem_budget.txt
+# (util/mem_report.py checks them on every build).
+
+budget: $(PATTERN).elf
+	python3 ../util/mem_report.py -q --irq-root irq_vector --objdump $(PROFILE_OBJDUMP) --accept $<
+
+.PHONY: budget
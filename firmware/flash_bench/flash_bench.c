@@ -0,0 +1,72 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../flash_io.h"
+
+// Instruction fetch benchmark for the flash read modes.  Two workloads run
+// from flash:  a long straight-line loop body (sequential fetch, limited
+// by the flash data rate) and a chain of short calls (every jump restarts
+// the read, limited by command, address and dummy cycles).  Each is timed
+// in the reset mode, in the mode flash_speed_init() selects and, if that
+// uses continuous read, in the same mode without it.
+
+#define ITER 16
+
+#define STEP	x += i; x ^= x << 3; x += 0x55; x ^= x >> 5;
+#define STEP4	STEP STEP STEP STEP
+
+static uint32_t straight(uint32_t n)
+{
+    uint32_t x = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        STEP4 STEP4 STEP4 STEP4
+    }
+    return x;
+}
+
+static uint32_t leaf(uint32_t x) { return x + 1; }
+static uint32_t call2(uint32_t x) { return leaf(leaf(x)); }
+static uint32_t call4(uint32_t x) { return call2(call2(x)); }
+
+static uint32_t calls(uint32_t n)
+{
+    uint32_t x = 0;
+    for (uint32_t i = 0; i < n; i++)
+        x = call4(call4(x));
+    return x;
+}
+
+static void run(const char *name)
+{
+    uint32_t start, seq, jump;
+
+    start = time_cycles();
+    straight(ITER);
+    seq = time_elapsed(start);
+    start = time_cycles();
+    calls(ITER);
+    jump = time_elapsed(start);
+    print_fmt("%-10s spictrl %08x  straight %8u  calls %8u cycles\n",
+              name, reg_spictrl, seq, jump);
+}
+
+void main()
+{
+    uint32_t mode;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("flash_bench\n");
+    print_fmt("jedec id   %06x\n", flash_jedec_id());
+
+    run("reset");
+    mode = flash_speed_init();
+    run("fastest");
+    if (mode & FLASH_MODE_CRM) {
+        flash_mode_set(mode & ~FLASH_MODE_CRM);
+        run("no crm");
+        flash_mode_set(mode);
+    }
+}
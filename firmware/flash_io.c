@@ -0,0 +1,153 @@
+#include "flash_io.h"
+#include "irq_io.h"
+
+// flashio_worker and flashmode_worker (start.s) take the flash out of
+// memory mode, so they are copied onto the stack and run from RAM with
+// IRQs masked (the IRQ vector is in flash).
+#define FLASH_WORKER_WORDS	48
+
+// Words compared after each mode change:  the start of the image (reset
+// jump and IRQ vector) is always programmed.
+#define FLASH_VERIFY_ADDR	0x10000000
+#define FLASH_VERIFY_WORDS	16
+
+// Status polls by flash_write() (about 80 us each at 10 MHz; a sector
+// erase can take 400 ms)
+#define FLASH_WRITE_POLLS	100000
+
+// Tried in order by flash_speed_init(), each with 0 to 8 dummy cycles
+static const uint32_t flash_modes[] = {
+    FLASH_MODE_DUAL | FLASH_MODE_CRM,
+    FLASH_MODE_DUAL,
+};
+
+static int flash_worker_copy(uint32_t *func, uint32_t *begin, uint32_t *end)
+{
+    if (end - begin > FLASH_WORKER_WORDS)
+        return -1;
+    while (begin != end)
+        *func++ = *begin++;
+    return 0;
+}
+
+/*
+ * flash_io()
+ * ----------------------------------------------------------------------------
+ * send len bytes to the flash in manual mode (each word of data MSB first)
+ * and replace them with the bytes read back; wrencmd, if not 0, is sent
+ * as a separate command first
+ */
+void flash_io(uint32_t *data, int len, uint32_t wrencmd)
+{
+    uint32_t func[FLASH_WORKER_WORDS];
+    uint32_t mask;
+
+    if (flash_worker_copy(func, &flashio_worker_begin, &flashio_worker_end))
+        return;
+
+    mask = irq_setmask(0xffffffff);
+    ((void (*)(uint32_t *, int, uint32_t)) func)(data, len, wrencmd);
+    irq_setmask(mask);
+}
+
+/*
+ * flash_jedec_id()
+ * ----------------------------------------------------------------------------
+ * read the 24-bit JEDEC ID (manufacturer, type, capacity), after taking
+ * the flash out of continuous read mode
+ */
+uint32_t flash_jedec_id()
+{
+    uint32_t data;
+
+    data = 0xffff0000;
+    flash_io(&data, 2, 0);
+    data = 0x9f000000;
+    flash_io(&data, 4, 0);
+    return data & 0xffffff;
+}
+
+/*
+ * flash_mode()
+ * ----------------------------------------------------------------------------
+ * the current read mode bits of reg_spictrl
+ */
+uint32_t flash_mode()
+{
+    return reg_spictrl & FLASH_MODE_MASK;
+}
+
+/*
+ * flash_mode_set()
+ * ----------------------------------------------------------------------------
+ * switch to another read mode (FLASH_MODE_* bits and dummy cycles) and
+ * verify flash reads in it; returns -1 and keeps the current mode if the
+ * flash does not read back correctly
+ */
+int flash_mode_set(uint32_t mode)
+{
+    uint32_t func[FLASH_WORKER_WORDS];
+    uint32_t ref[FLASH_VERIFY_WORDS];
+    const uint32_t *flash = (const uint32_t *) FLASH_VERIFY_ADDR;
+    uint32_t ctrl = reg_spictrl;
+    uint32_t mask;
+    int errors;
+
+    if (flash_worker_copy(func, &flashmode_worker_begin, &flashmode_worker_end))
+        return -1;
+    for (int i = 0; i < FLASH_VERIFY_WORDS; i++)
+        ref[i] = flash[i];
+
+    mask = irq_setmask(0xffffffff);
+    errors = ((int (*)(uint32_t, uint32_t *, int, const uint32_t *, uint32_t)) func)(
+        (ctrl & ~FLASH_MODE_MASK) | (mode & FLASH_MODE_MASK),
+        ref, FLASH_VERIFY_WORDS, flash, ctrl);
+    irq_setmask(mask);
+    return errors ? -1 : 0;
+}
+
+/*
+ * flash_speed_init()
+ * ----------------------------------------------------------------------------
+ * call once at boot:  if a W25Q is attached, switch to the fastest read
+ * mode that verifies.  Returns the mode in use (the reset mode if the part
+ * is not recognized or no faster mode works).
+ */
+uint32_t flash_speed_init()
+{
+    if ((flash_jedec_id() >> 8) != FLASH_JEDEC_W25Q)
+        return flash_mode();
+
+    for (int i = 0; i < sizeof(flash_modes) / sizeof(flash_modes[0]); i++)
+        for (uint32_t dummy = 0; dummy <= 8; dummy++)
+            if (flash_mode_set(flash_modes[i] | FLASH_MODE_DUMMY(dummy)) == 0)
+                return flash_mode();
+    return flash_mode();
+}
+
+/*
+ * flash_write()
+ * ----------------------------------------------------------------------------
+ * send WREN and a program or erase command (words of command, address and
+ * data, each MSB first), then wait for the flash to finish:  it cannot be
+ * read until then, so the whole sequence runs from RAM with IRQs masked.
+ * Returns -1 without sending anything if words < 1 (the worker needs at
+ * least the command word), or if the flash is still busy after
+ * FLASH_WRITE_POLLS polls.
+ */
+int flash_write(uint32_t *data, int words)
+{
+    uint32_t func[FLASH_WORKER_WORDS];
+    uint32_t mask;
+    int busy;
+
+    if (words < 1)
+        return -1;
+    if (flash_worker_copy(func, &flashprog_worker_begin, &flashprog_worker_end))
+        return -1;
+
+    mask = irq_setmask(0xffffffff);
+    busy = ((int (*)(uint32_t *, int, uint32_t)) func)(data, words, FLASH_WRITE_POLLS);
+    irq_setmask(mask);
+    return busy ? -1 : 0;
+}
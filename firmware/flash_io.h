@@ -0,0 +1,37 @@
+#ifndef FLASH_IO_H
+#define FLASH_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Flash controller (spimemio) read mode bits in reg_spictrl.  spimemio
+// calls the dual I/O mode "DDR"; quad and quad DDR need IO2/IO3, which
+// Caravel does not bond out, so dual I/O with continuous read (no command
+// byte per read) is the fastest mode available.
+#define FLASH_MODE_MASK		0x007f0000
+#define FLASH_MODE_DUAL		0x00400000
+#define FLASH_MODE_QUAD		0x00200000
+#define FLASH_MODE_CRM		0x00100000
+#define FLASH_MODE_DUMMY(n)	(((n) & 0xf) << 16)
+
+// JEDEC manufacturer and memory type of the Winbond W25Q series
+#define FLASH_JEDEC_W25Q	0xef40
+
+// W25Q program and erase commands for flash_write(), and their units
+#define FLASH_CMD_PROGRAM	0x02	// page program, up to FLASH_PAGE bytes
+#define FLASH_CMD_ERASE		0x20	// sector erase, FLASH_SECTOR bytes
+#define FLASH_PAGE		256
+#define FLASH_SECTOR		4096
+
+extern uint32_t flashmode_worker_begin;
+extern uint32_t flashmode_worker_end;
+extern uint32_t flashprog_worker_begin;
+extern uint32_t flashprog_worker_end;
+
+void flash_io(uint32_t *data, int len, uint32_t wrencmd);
+uint32_t flash_jedec_id();
+uint32_t flash_mode();
+int flash_mode_set(uint32_t mode);
+uint32_t flash_speed_init();
+int flash_write(uint32_t *data, int words);
+
+#endif // FLASH_IO_H
@@ -0,0 +1,98 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../flashlog_io.h"
+
+// Burn-in logging example.  Each boot appends a boot record to the flash
+// log, then runs the self tests and logs a result record for each one,
+// flushed as soon as it is written:  a rack that resets or powers off the
+// board keeps every completed test.  util/caravel_flashlog.py reads the
+// log back over the housekeeping SPI.
+
+#define LOG_BOOT	1	// seq, records, ring sector at boot
+#define LOG_RESULT	2	// test, pass, cycles, value
+
+#define TEST_RAM	1
+#define TEST_FLASH	2
+
+#define RAM_TEST_WORDS	8
+#define FLASH_SUM_WORDS	1024	// start of the image
+
+// the page buffer takes a quarter of the RAM
+static flashlog_t flash_log;
+
+// walking ones and their complements, on the stack (not in use by the log
+// at this point); returns the words in error
+static uint32_t test_ram(void)
+{
+    volatile uint32_t buf[RAM_TEST_WORDS];
+    uint32_t errors = 0;
+
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        for (int i = 0; i < RAM_TEST_WORDS; i++)
+            buf[i] = (i & 1) ? ~(1 << bit) : (1 << bit);
+        for (int i = 0; i < RAM_TEST_WORDS; i++)
+            if (buf[i] != ((i & 1) ? ~(1 << bit) : (1 << bit)))
+                errors++;
+    }
+    return errors;
+}
+
+// rotate-and-add over the start of the image, the same on every boot
+static uint32_t test_flash(void)
+{
+    const uint32_t *flash = (const uint32_t *) 0x10000000;
+    uint32_t sum = 0;
+
+    for (int i = 0; i < FLASH_SUM_WORDS; i++)
+        sum = ((sum << 1) | (sum >> 31)) + flash[i];
+    return sum;
+}
+
+static void result(uint32_t test, uint32_t pass, uint32_t cycles, uint32_t value)
+{
+    uint32_t rec[4];
+
+    rec[0] = test;
+    rec[1] = pass;
+    rec[2] = cycles;
+    rec[3] = value;
+    if (flashlog_append(&flash_log, LOG_RESULT, rec, 4) || flashlog_flush(&flash_log))
+        print("log write failed\n");
+    print_fmt("test %u %s  %u cycles  %08x\n", test, pass ? "pass" : "FAIL", cycles, value);
+}
+
+void main()
+{
+    uint32_t rec[3];
+    uint32_t start, value;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("flashlog\n");
+    start = time_cycles();
+    if (flashlog_open(&flash_log)) {
+        print("log open failed\n");
+        return;
+    }
+    print_fmt("log sector %u seq %u records %u (%u cycles)\n",
+              flash_log.sector, flash_log.seq, flash_log.records, time_elapsed(start));
+
+    rec[0] = flash_log.seq;
+    rec[1] = flash_log.records;
+    rec[2] = flash_log.sector;
+    if (flashlog_append(&flash_log, LOG_BOOT, rec, 3) || flashlog_flush(&flash_log))
+        print("log write failed\n");
+
+    start = time_cycles();
+    value = test_ram();
+    result(TEST_RAM, value == 0, time_elapsed(start), value);
+
+    start = time_cycles();
+    value = test_flash();
+    result(TEST_FLASH, 1, time_elapsed(start), value);
+
+    print("done\n");
+}
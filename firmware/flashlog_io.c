@@ -0,0 +1,185 @@
+#include "flashlog_io.h"
+#include "flash_io.h"
+
+#define FLASHLOG_ERASED		0xffffffff
+
+static uint32_t flashlog_sector(uint32_t sector)
+{
+    return FLASHLOG_BASE + sector * FLASHLOG_SECTOR;
+}
+
+// flash_write() sends each word MSB first; the flash controller reads the
+// lowest address into the LSB
+static uint32_t flashlog_swap(uint32_t w)
+{
+    return (w >> 24) | ((w >> 8) & 0xff00) | ((w << 8) & 0xff0000) | (w << 24);
+}
+
+/*
+ * flashlog_check()
+ * ----------------------------------------------------------------------------
+ * the 16-bit check of a record:  a rotate-and-add over the low half of the
+ * header and the payload, folded (see util/caravel_flashlog.py)
+ */
+uint32_t flashlog_check(uint32_t header, const uint32_t *data, uint32_t words)
+{
+    uint32_t sum = 0x5a5a0000 | (header & 0xffff);
+
+    for (uint32_t i = 0; i < words; i++)
+        sum = ((sum << 1) | (sum >> 31)) + data[i];
+    return (sum ^ (sum >> 16)) & 0xffff;
+}
+
+/*
+ * flashlog_flush()
+ * ----------------------------------------------------------------------------
+ * program the buffered words not yet in flash, as one page program
+ */
+int flashlog_flush(flashlog_t *log)
+{
+    uint32_t n = log->fill - log->done;
+    uint32_t *cmd = &log->io[log->done];
+
+    if (!n)
+        return 0;
+
+    // the word before the first new one is free:  io[0], or a programmed one
+    *cmd = (FLASH_CMD_PROGRAM << 24) | (log->addr + (log->done << 2));
+    for (uint32_t i = 1; i <= n; i++)
+        cmd[i] = flashlog_swap(cmd[i]);
+    log->done = log->fill;
+    return flash_write(cmd, 1 + n);
+}
+
+static int flashlog_put(flashlog_t *log, uint32_t word)
+{
+    if (log->fill == FLASHLOG_PAGE_WORDS) {
+        if (flashlog_flush(log))
+            return -1;
+        log->addr += FLASHLOG_PAGE;
+        log->fill = 0;
+        log->done = 0;
+    }
+    log->io[1 + log->fill++] = word;
+    return 0;
+}
+
+/*
+ * flashlog_rotate()
+ * ----------------------------------------------------------------------------
+ * erase the next sector in the ring and start it with a header one
+ * sequence number on.  A valid header there is cleared first, so an erase
+ * cut short by a power fail cannot leave a half-erased sector that still
+ * looks like part of the log.
+ */
+static int flashlog_rotate(flashlog_t *log)
+{
+    uint32_t next = log->sector + 1 == FLASHLOG_SECTORS ? 0 : log->sector + 1;
+    uint32_t off = flashlog_sector(next);
+    uint32_t data[2];
+
+    if (*FLASHLOG_XIP(off) == FLASHLOG_MAGIC) {
+        data[0] = (FLASH_CMD_PROGRAM << 24) | off;
+        data[1] = 0;
+        if (flash_write(data, 2))
+            return -1;
+    }
+    data[0] = (FLASH_CMD_ERASE << 24) | off;
+    if (flash_write(data, 1))
+        return -1;
+
+    log->sector = next;
+    log->seq++;
+    log->addr = off;
+    log->fill = 0;
+    log->done = 0;
+    log->records = 0;
+    log->io[1 + log->fill++] = FLASHLOG_MAGIC;
+    log->io[1 + log->fill++] = log->seq;
+    log->io[1 + log->fill++] = ~log->seq;
+    log->io[1 + log->fill++] = FLASHLOG_SECTORS;
+    return flashlog_flush(log);
+}
+
+/*
+ * flashlog_open()
+ * ----------------------------------------------------------------------------
+ * find the end of the log:  the sector with the highest sequence number,
+ * scanned through the flash window up to its first erased word.  If that
+ * sector holds a record that fails its check, or anything after its end,
+ * appends go to the next sector instead (as they do on an empty log).
+ * Returns -1 on a flash error.
+ */
+int flashlog_open(flashlog_t *log)
+{
+    const uint32_t *p;
+    uint32_t pos, header, words;
+    int found = 0;
+
+    log->sector = FLASHLOG_SECTORS - 1;
+    log->seq = 0;
+    for (uint32_t s = 0; s < FLASHLOG_SECTORS; s++) {
+        p = FLASHLOG_XIP(flashlog_sector(s));
+        if (p[0] != FLASHLOG_MAGIC || p[2] != ~p[1] || p[3] != FLASHLOG_SECTORS)
+            continue;
+        if (!found || (int32_t) (p[1] - log->seq) > 0) {
+            log->sector = s;
+            log->seq = p[1];
+        }
+        found = 1;
+    }
+    if (!found)
+        return flashlog_rotate(log);
+
+    p = FLASHLOG_XIP(flashlog_sector(log->sector));
+    pos = FLASHLOG_HEADER_WORDS;
+    log->records = 0;
+    while (pos < FLASHLOG_SECTOR_WORDS && (header = p[pos]) != FLASHLOG_ERASED) {
+        words = header & 0xff;
+        if (words > FLASHLOG_RECORD_WORDS || pos + 1 + words > FLASHLOG_SECTOR_WORDS ||
+            flashlog_check(header, &p[pos + 1], words) != header >> 16)
+            return flashlog_rotate(log);
+        pos += 1 + words;
+        log->records++;
+    }
+    for (uint32_t i = pos; i < FLASHLOG_SECTOR_WORDS; i++)
+        if (p[i] != FLASHLOG_ERASED)
+            return flashlog_rotate(log);
+
+    log->addr = flashlog_sector(log->sector) + ((pos & ~(FLASHLOG_PAGE_WORDS - 1)) << 2);
+    log->fill = pos & (FLASHLOG_PAGE_WORDS - 1);
+    log->done = log->fill;
+    return 0;
+}
+
+/*
+ * flashlog_append()
+ * ----------------------------------------------------------------------------
+ * add a record of words payload words (at most FLASHLOG_RECORD_WORDS) and
+ * an 8-bit type to the page buffer, programming full pages on the way and
+ * moving to the next sector if the record does not fit in this one.  The
+ * record is in flash once the page fills or flashlog_flush() is called.
+ * Returns -1 on a flash error or if the record is too long.
+ */
+int flashlog_append(flashlog_t *log, uint32_t type, const uint32_t *data, uint32_t words)
+{
+    uint32_t header, pos;
+
+    if (words > FLASHLOG_RECORD_WORDS)
+        return -1;
+
+    pos = ((log->addr - flashlog_sector(log->sector)) >> 2) + log->fill;
+    if (pos + 1 + words > FLASHLOG_SECTOR_WORDS)
+        if (flashlog_flush(log) || flashlog_rotate(log))
+            return -1;
+
+    header = words | ((type & 0xff) << 8);
+    header |= flashlog_check(header, data, words) << 16;
+    if (flashlog_put(log, header))
+        return -1;
+    for (uint32_t i = 0; i < words; i++)
+        if (flashlog_put(log, data[i]))
+            return -1;
+    log->records++;
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef FLASHLOG_IO_H
+#define FLASHLOG_IO_H
+
+#include "flash_io.h"
+
+// Append-only record log in a reserved region of the SPI flash, kept
+// across resets and power cycles (util/caravel_flashlog.py reads it back).
+//
+// The region is a ring of FLASHLOG_SECTORS erase sectors.  Each sector in
+// use starts with a header (FLASHLOG_MAGIC, a sequence number and its
+// complement, the ring size) and holds records up to its end; when a
+// record does not fit, the oldest sector is erased and becomes the next
+// one, so erases go round the whole ring.  A record is a header word
+//
+//   bits  0-7   payload words (at most FLASHLOG_RECORD_WORDS)
+//   bits  8-15  type
+//   bits 16-31  check over the header and payload
+//
+// and its payload;  the log ends at the first erased (0xffffffff) word.
+// Records are collected in a page buffer and programmed with flash_write()
+// when the page is full or on flashlog_flush(), each word stored so that
+// it reads back the same through the flash controller.
+//
+// Power fail:  programs only clear bits and a header is written after its
+// sector is erased, so an interrupted program or erase leaves a record
+// that fails its check or a sector without a valid header.  flashlog_open()
+// carries on in a fresh sector if the last one does not end cleanly.
+// Records still in the buffer are lost:  flush after each one that must
+// survive.
+//
+// The region must not overlap the firmware image, which caravel_hkflash.py
+// programs from offset 0 (it erases the whole part, log included).
+
+#define FLASHLOG_BASE		0x300000	// flash offset, sector aligned
+#define FLASHLOG_SECTORS	16
+#define FLASHLOG_SECTOR		FLASH_SECTOR
+#define FLASHLOG_PAGE		FLASH_PAGE
+
+#define FLASHLOG_MAGIC		0x31474c46	// "FLG1"
+#define FLASHLOG_HEADER_WORDS	4
+#define FLASHLOG_PAGE_WORDS	(FLASHLOG_PAGE / 4)
+#define FLASHLOG_SECTOR_WORDS	(FLASHLOG_SECTOR / 4)
+#define FLASHLOG_RECORD_WORDS	64
+
+// flash offset to address in the flash window
+#define FLASHLOG_XIP(off)	((const uint32_t *) (0x10000000 + (off)))
+
+typedef struct {
+    uint32_t sector;	// ring index of the sector in use
+    uint32_t seq;	// its sequence number
+    uint32_t addr;	// flash offset of the page in the buffer
+    uint32_t fill;	// words in the page buffer
+    uint32_t done;	// of which programmed
+    uint32_t records;	// records in the sector in use
+    // io[0] and, once programmed, buffer words are reused for the command
+    uint32_t io[1 + FLASHLOG_PAGE_WORDS];
+} flashlog_t;
+
+int flashlog_open(flashlog_t *log);
+int flashlog_append(flashlog_t *log, uint32_t type, const uint32_t *data, uint32_t words);
+int flashlog_flush(flashlog_t *log);
+uint32_t flashlog_check(uint32_t header, const uint32_t *data, uint32_t words);
+
+#endif // FLASHLOG_IO_H
@@ -0,0 +1,64 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+
+static inline uint32_t rdcycle()
+{
+    uint32_t cycles;
+    __asm__ volatile ("rdcycle %0" : "=r"(cycles));
+    return cycles;
+}
+
+static void report(const char *name, const char *buf, int len, uint32_t cycles)
+{
+    print(name);
+    print(" ");
+    for (int i = 0; i < len; i++)
+        putchar(buf[i]);
+    print_fmt(" %u cycles\n", cycles);
+}
+
+void main()
+{
+    char buf[FMT_U64_LEN + 2];
+    uint32_t start, cycles;
+    int len;
+
+    static const uint32_t u32[] = {0, 7, 1999, 2000, 65535, 123456789, 0xffffffff};
+    static const uint64_t u64[] = {0, 4294967296ULL, 1000000000000ULL, 0xffffffffffffffffULL};
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("fmt_bench\n");
+
+    for (int i = 0; i < sizeof(u32) / sizeof(u32[0]); i++) {
+        start = rdcycle();
+        len = fmt_u32(buf, u32[i]);
+        cycles = rdcycle() - start;
+        report("fmt_u32", buf, len, cycles);
+    }
+
+    for (int i = 0; i < sizeof(u64) / sizeof(u64[0]); i++) {
+        start = rdcycle();
+        len = fmt_u64(buf, u64[i]);
+        cycles = rdcycle() - start;
+        report("fmt_u64", buf, len, cycles);
+    }
+
+    start = rdcycle();
+    len = fmt_i32(buf, -2147483647 - 1);
+    cycles = rdcycle() - start;
+    report("fmt_i32", buf, len, cycles);
+
+    start = rdcycle();
+    len = fmt_hex(buf, 0xdeadbeef, 8);
+    cycles = rdcycle() - start;
+    report("fmt_hex", buf, len, cycles);
+
+    // -3.25 in Q16.16
+    start = rdcycle();
+    len = fmt_fixed(buf, -((3 << 16) + (1 << 14)), 16, 4);
+    cycles = rdcycle() - start;
+    report("fmt_fixed", buf, len, cycles);
+}
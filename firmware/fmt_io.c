@@ -0,0 +1,313 @@
+#include <stdarg.h>
+
+#include "fmt_io.h"
+#include "print_io.h"
+
+// ============================================================================
+// CONVERSION
+// ============================================================================
+/*
+ * divu10()
+ * ----------------------------------------------------------------------------
+ * n / 10 and n % 10 by shift-add reciprocal multiplication (q ~= n * 0.8 / 8,
+ * then one correction step).  Exact for every 32-bit n, ~25 instructions.
+ */
+uint32_t divu10(uint32_t n, uint32_t *rem)
+{
+    uint32_t q, r;
+
+    q = (n >> 1) + (n >> 2);
+    q = q + (q >> 4);
+    q = q + (q >> 8);
+    q = q + (q >> 16);
+    q = q >> 3;
+    r = n - (((q << 2) + q) << 1);
+    if (r > 9) {
+        q++;
+        r -= 10;
+    }
+    *rem = r;
+    return q;
+}
+
+/*
+ * divu10_64()
+ * ----------------------------------------------------------------------------
+ * 64-bit divu10(); only constant shifts, so no libgcc helpers are needed
+ */
+uint64_t divu10_64(uint64_t n, uint32_t *rem)
+{
+    uint64_t q, r;
+
+    q = (n >> 1) + (n >> 2);
+    q = q + (q >> 4);
+    q = q + (q >> 8);
+    q = q + (q >> 16);
+    q = q + (q >> 32);
+    q = q >> 3;
+    r = n - (((q << 2) + q) << 1);
+    if (r > 9) {
+        q++;
+        r -= 10;
+    }
+    *rem = (uint32_t) r;
+    return q;
+}
+
+/*
+ * frac16()
+ * ----------------------------------------------------------------------------
+ * num / den for num <= den, with 16 fraction bits (65536 = 1; 0 if den is
+ * 0).  Both are scaled down to 16 bits first, so one __udivsi3 does it.
+ */
+uint32_t frac16(uint64_t num, uint64_t den)
+{
+    while (den >> 16) {
+        den >>= 1;
+        num >>= 1;
+    }
+    if (!den)
+        return 0;
+    return ((uint32_t) num << 16) / (uint32_t) den;
+}
+
+/*
+ * frac16_percent()
+ * ----------------------------------------------------------------------------
+ * a frac16() value times 100, still with 16 fraction bits (shifts and adds)
+ */
+uint32_t frac16_percent(uint32_t frac)
+{
+    return (frac << 6) + (frac << 5) + (frac << 2);
+}
+
+static int fmt_reverse(char *buf, char *tmp, int len)
+{
+    for (int i = 0; i < len; i++)
+        buf[i] = tmp[len - 1 - i];
+    return len;
+}
+
+int fmt_u32(char *buf, uint32_t v)
+{
+    char tmp[FMT_U32_LEN];
+    uint32_t r;
+    int len = 0;
+
+    do {
+        v = divu10(v, &r);
+        tmp[len++] = '0' + r;
+    } while (v);
+    return fmt_reverse(buf, tmp, len);
+}
+
+int fmt_i32(char *buf, int32_t v)
+{
+    if (v < 0) {
+        buf[0] = '-';
+        return 1 + fmt_u32(buf + 1, -(uint32_t) v);
+    }
+    return fmt_u32(buf, v);
+}
+
+int fmt_u64(char *buf, uint64_t v)
+{
+    char tmp[FMT_U64_LEN];
+    uint32_t r;
+    int len = 0;
+
+    // Switch to the cheaper 32-bit loop as soon as the value fits
+    while (v >> 32) {
+        v = divu10_64(v, &r);
+        tmp[len++] = '0' + r;
+    }
+    uint32_t w = (uint32_t) v;
+    do {
+        w = divu10(w, &r);
+        tmp[len++] = '0' + r;
+    } while (w);
+    return fmt_reverse(buf, tmp, len);
+}
+
+int fmt_i64(char *buf, int64_t v)
+{
+    if (v < 0) {
+        buf[0] = '-';
+        return 1 + fmt_u64(buf + 1, -(uint64_t) v);
+    }
+    return fmt_u64(buf, v);
+}
+
+/*
+ * fmt_hex()
+ * ----------------------------------------------------------------------------
+ * v in lower case hex, zero padded to digits (0 = as many as needed)
+ */
+int fmt_hex(char *buf, uint32_t v, int digits)
+{
+    if (digits <= 0) {
+        digits = 1;
+        while (digits < 8 && (v >> (digits << 2)))
+            digits++;
+    }
+    for (int i = 0; i < digits; i++)
+        buf[i] = "0123456789abcdef"[(v >> ((digits - 1 - i) << 2)) & 15];
+    return digits;
+}
+
+/*
+ * fmt_fixed()
+ * ----------------------------------------------------------------------------
+ * signed fixed-point value with frac_bits fraction bits (at most 28),
+ * printed with the given number of decimals (truncated, not rounded)
+ */
+int fmt_fixed(char *buf, int32_t v, int frac_bits, int decimals)
+{
+    uint32_t mag = v < 0 ? -(uint32_t) v : v;
+    uint32_t mask = (1 << frac_bits) - 1;
+    uint32_t frac = mag & mask;
+    int len = 0;
+
+    if (v < 0)
+        buf[len++] = '-';
+    len += fmt_u32(buf + len, mag >> frac_bits);
+    if (decimals > 0)
+        buf[len++] = '.';
+    for (int i = 0; i < decimals; i++) {
+        frac = (frac << 3) + (frac << 1);
+        buf[len++] = '0' + (frac >> frac_bits);
+        frac &= mask;
+    }
+    return len;
+}
+// ============================================================================
+
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+static void print_buf(const char *buf, int len)
+{
+    for (int i = 0; i < len; i++)
+        putchar(buf[i]);
+}
+
+void print_u64(uint64_t v)
+{
+    char buf[FMT_U64_LEN];
+    print_buf(buf, fmt_u64(buf, v));
+}
+
+void print_i32(int32_t v)
+{
+    char buf[FMT_U32_LEN + 1];
+    print_buf(buf, fmt_i32(buf, v));
+}
+
+void print_fixed(int32_t v, int frac_bits, int decimals)
+{
+    char buf[FMT_U32_LEN + 2 + 16];
+    if (decimals > 16)
+        decimals = 16;
+    print_buf(buf, fmt_fixed(buf, v, frac_bits, decimals));
+}
+
+/*
+ * print_fmt()
+ * ----------------------------------------------------------------------------
+ * printf subset:  %[-][0][width][l|ll](d|i|u|x|c|s|%)
+ */
+void print_fmt(const char *fmt, ...)
+{
+    char buf[FMT_U64_LEN + 1];
+    va_list ap;
+
+    va_start(ap, fmt);
+    while (*fmt) {
+        if (*fmt != '%') {
+            putchar(*fmt++);
+            continue;
+        }
+        fmt++;
+
+        int left = 0, pad = ' ', width = 0, longs = 0, len = 0;
+        const char *s = buf;
+
+        if (*fmt == '-') {
+            left = 1;
+            fmt++;
+        }
+        if (*fmt == '0') {
+            pad = '0';
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9')
+            width = (width << 3) + (width << 1) + (*fmt++ - '0');
+        while (*fmt == 'l') {
+            longs++;
+            fmt++;
+        }
+
+        switch (*fmt) {
+        case 'd':
+        case 'i':
+            if (longs > 1)
+                len = fmt_i64(buf, va_arg(ap, int64_t));
+            else
+                len = fmt_i32(buf, va_arg(ap, int32_t));
+            break;
+        case 'u':
+            if (longs > 1)
+                len = fmt_u64(buf, va_arg(ap, uint64_t));
+            else
+                len = fmt_u32(buf, va_arg(ap, uint32_t));
+            break;
+        case 'x':
+            if (longs > 1) {
+                uint64_t v = va_arg(ap, uint64_t);
+                if (v >> 32) {
+                    len = fmt_hex(buf, v >> 32, 0);
+                    len += fmt_hex(buf + len, (uint32_t) v, 8);
+                } else {
+                    len = fmt_hex(buf, (uint32_t) v, 0);
+                }
+            } else {
+                len = fmt_hex(buf, va_arg(ap, uint32_t), 0);
+            }
+            break;
+        case 'c':
+            buf[0] = va_arg(ap, int);
+            len = 1;
+            break;
+        case 's':
+            s = va_arg(ap, const char *);
+            while (s[len])
+                len++;
+            break;
+        case '%':
+            buf[0] = '%';
+            len = 1;
+            break;
+        default:
+            va_end(ap);
+            return;
+        }
+        fmt++;
+
+        // Zero padding goes after the sign
+        if (pad == '0' && !left && s == buf && buf[0] == '-' && len < width) {
+            putchar('-');
+            s++;
+            len--;
+            width--;
+        }
+        if (!left)
+            for (; width > len; width--)
+                putchar(pad);
+        print_buf(s, len);
+        for (; width > len; width--)
+            putchar(' ');
+    }
+    va_end(ap);
+}
+// ============================================================================
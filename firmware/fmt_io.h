@@ -0,0 +1,30 @@
+#ifndef FMT_IO_H
+#define FMT_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Integer formatting without multiply or divide instructions (rv32i, no
+// libgcc).  The fmt_* functions write into buf without a terminating zero
+// and return the number of characters written.
+
+#define FMT_U32_LEN	10	// "4294967295"
+#define FMT_U64_LEN	20	// "18446744073709551615"
+
+uint32_t divu10(uint32_t n, uint32_t *rem);
+uint64_t divu10_64(uint64_t n, uint32_t *rem);
+uint32_t frac16(uint64_t num, uint64_t den);
+uint32_t frac16_percent(uint32_t frac);
+
+int fmt_u32(char *buf, uint32_t v);
+int fmt_i32(char *buf, int32_t v);
+int fmt_u64(char *buf, uint64_t v);
+int fmt_i64(char *buf, int64_t v);
+int fmt_hex(char *buf, uint32_t v, int digits);
+int fmt_fixed(char *buf, int32_t v, int frac_bits, int decimals);
+
+void print_u64(uint64_t v);
+void print_i32(int32_t v);
+void print_fixed(int32_t v, int frac_bits, int decimals);
+void print_fmt(const char *fmt, ...);
+
+#endif // FMT_IO_H
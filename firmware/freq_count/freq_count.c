@@ -0,0 +1,60 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../gpio_config_io.h"
+#include "../freq_io.h"
+
+// Frequency, duty cycle, period and jitter of a clock on FREQ_PAD.
+//
+// Build with -DFREQ_MONITOR=CLOCK2_MONITOR (or CLOCK1_MONITOR) to measure
+// one of Caravel's own clocks:  the clock monitor drives it out on IO[15]
+// (IO[14] for clock 1), so that pad is set up as a management output with
+// its input enabled and read back.  Only clocks divided well below the
+// poll rate can be followed this way.
+
+#if defined(FREQ_MONITOR)
+#undef FREQ_PAD
+#if FREQ_MONITOR == CLOCK1_MONITOR
+#define FREQ_PAD	14
+#else
+#define FREQ_PAD	15
+#endif
+#define FREQ_PAD_MODE	GPIO_MODE_MGMT_STD_OUT_MONITORED
+#else
+#ifndef FREQ_PAD
+#define FREQ_PAD	15
+#endif
+#define FREQ_PAD_MODE	GPIO_MODE_MGMT_STD_INPUT_NOPULL
+#endif
+
+#define GATE_CYCLES	(TIME_CLOCK_HZ / 10)	// 100 ms
+#define EDGE_TIMEOUT	100000			// polls
+
+static const gpio_config_t freq_pads[] = {
+    GPIO_PAD(6, 0x7ff),
+    GPIO_PAD(FREQ_PAD, FREQ_PAD_MODE),
+};
+
+static freq_gate_t gate;
+static freq_edges_t edges;
+
+void main()
+{
+    gpio_config(freq_pads, GPIO_CONFIG_LEN(freq_pads));
+    reg_uart_enable = 1;
+#ifdef FREQ_MONITOR
+    reg_clk_out_dest = FREQ_MONITOR;
+#endif
+
+    print_fmt("freq_count: pad %u\n", FREQ_PAD);
+
+    gate.gate = GATE_CYCLES;
+    if (freq_gate(FREQ_PAD, &gate) != 0)
+        print("gate failed\n");
+    if (freq_edges(FREQ_PAD, &edges, EDGE_TIMEOUT) != 0)
+        print_fmt("edges: timed out after %u\n", edges.n);
+    else
+        freq_stats(&edges);
+    freq_report(&gate, &edges);
+}
@@ -0,0 +1,178 @@
+#include "freq_io.h"
+#include "print_io.h"
+#include "fmt_io.h"
+#include "time_io.h"
+#include "ramfunc.h"
+
+// Both loops run from RAM and do the same work on every poll, so polls
+// are evenly spaced and the high count gives the duty cycle.
+
+#define freq_rdcycle(cycles) __asm__ volatile ("rdcycle %0" : "=r"(cycles))
+
+// Pad and loop state, passed to the RAM loops as one pointer
+typedef struct {
+    volatile uint32_t *src;	// reg_mprj_datal or reg_mprj_datah
+    uint32_t shift;		// pad bit in it
+} freq_pad_t;
+
+static int freq_pad(uint32_t pad, freq_pad_t *p)
+{
+    if (pad >= 38)
+        return -1;
+    p->src = pad < 32 ? &reg_mprj_datal : &reg_mprj_datah;
+    p->shift = pad & 31;
+    return 0;
+}
+
+/*
+ * freq_gate_loop()
+ * ----------------------------------------------------------------------------
+ * poll the pad until counter-timer 0 has run out
+ */
+RAMFUNC static void freq_gate_loop(const freq_pad_t *p, freq_gate_t *g)
+{
+    volatile uint32_t *src = p->src;
+    uint32_t shift = p->shift;
+    uint32_t prev = (*src >> shift) & 1;
+    uint32_t v, edges = 0, high = 0, polls = 0;
+
+    while (reg_timer0_value) {
+        v = (*src >> shift) & 1;
+        edges += v & (prev ^ 1);
+        high += v;
+        prev = v;
+        polls++;
+    }
+    g->edges = edges;
+    g->high = high;
+    g->polls = polls;
+}
+
+/*
+ * freq_edges_loop()
+ * ----------------------------------------------------------------------------
+ * time the rising edges; gives up after timeout polls without one
+ */
+RAMFUNC static uint32_t freq_edges_loop(const freq_pad_t *p, uint32_t *t, uint32_t timeout)
+{
+    volatile uint32_t *src = p->src;
+    uint32_t shift = p->shift;
+    uint32_t prev = (*src >> shift) & 1;
+    uint32_t v, now, n = 0, idle = 0;
+
+    while (n < FREQ_EDGES) {
+        freq_rdcycle(now);
+        v = (*src >> shift) & 1;
+        if (v & (prev ^ 1)) {
+            t[n++] = now;
+            idle = 0;
+        } else if (++idle == timeout) {
+            break;
+        }
+        prev = v;
+    }
+    return n;
+}
+
+/*
+ * freq_gate()
+ * ----------------------------------------------------------------------------
+ * count the pad's edges over g->gate cycles; returns 0, or -1 for a bad pad
+ */
+int freq_gate(uint32_t pad, freq_gate_t *g)
+{
+    freq_pad_t p;
+    uint32_t start;
+
+    if (freq_pad(pad, &p) != 0 || !g->gate)
+        return -1;
+
+    reg_timer0_config = 0;
+    reg_timer0_data = 0;
+    reg_timer0_value = g->gate;
+    start = time_cycles();
+    reg_timer0_config = TIMER_ENABLE | TIMER_ONESHOT;
+    freq_gate_loop(&p, g);
+    g->cycles = time_elapsed(start);
+    reg_timer0_config = 0;
+    return 0;
+}
+
+/*
+ * freq_edges()
+ * ----------------------------------------------------------------------------
+ * record FREQ_EDGES rising edge times; returns 0, or -1 if fewer came
+ * (timeout polls without an edge, 0 = wait forever) or the pad is bad
+ */
+int freq_edges(uint32_t pad, freq_edges_t *e, uint32_t timeout)
+{
+    freq_pad_t p;
+
+    e->n = 0;
+    if (freq_pad(pad, &p) != 0)
+        return -1;
+    e->n = freq_edges_loop(&p, e->t, timeout);
+    return e->n == FREQ_EDGES ? 0 : -1;
+}
+
+/*
+ * freq_stats()
+ * ----------------------------------------------------------------------------
+ * period statistics of a full set of edge times; returns 0, or -1 if the
+ * set is not full
+ */
+int freq_stats(freq_edges_t *e)
+{
+    uint32_t sum = 0, dev = 0, d, mean;
+
+    if (e->n != FREQ_EDGES)
+        return -1;
+    e->min = 0xffffffff;
+    e->max = 0;
+    for (uint32_t i = 1; i < FREQ_EDGES; i++) {
+        d = e->t[i] - e->t[i - 1];
+        sum += d;
+        if (d < e->min)
+            e->min = d;
+        if (d > e->max)
+            e->max = d;
+    }
+    // FREQ_EDGES - 1 periods, a power of two
+    mean = (sum << 4) >> FREQ_EDGES_LOG2;
+    for (uint32_t i = 1; i < FREQ_EDGES; i++) {
+        d = (e->t[i] - e->t[i - 1]) << 4;
+        dev += d > mean ? d - mean : mean - d;
+    }
+    e->mean = mean;
+    e->mad = dev >> FREQ_EDGES_LOG2;
+    return 0;
+}
+
+/*
+ * freq_report()
+ * ----------------------------------------------------------------------------
+ * print frequency and duty cycle from the gate count, and period and
+ * jitter from the edge times (either may be 0)
+ */
+void freq_report(const freq_gate_t *g, const freq_edges_t *e)
+{
+    uint32_t duty;
+
+    if (g) {
+        print_fmt("gate %u cycles: %u edges, %u Hz, poll %u Hz, duty ",
+                  g->cycles, g->edges, time_rate(g->edges, g->cycles),
+                  time_rate(g->polls, g->cycles));
+        // high polls in percent
+        duty = frac16(g->high, g->polls);
+        print_fixed(frac16_percent(duty), 16, 1);
+        print("%\n");
+    }
+    if (e && e->n == FREQ_EDGES) {
+        print_fmt("%u periods: min %u max %u mean ", FREQ_EDGES - 1, e->min, e->max);
+        print_fixed(e->mean, 4, 1);
+        print_fmt(" cycles, %u Hz, jitter p-p %u mad ",
+                  time_rate(FREQ_EDGES - 1, e->t[FREQ_EDGES - 1] - e->t[0]), e->max - e->min);
+        print_fixed(e->mad, 4, 1);
+        print(" cycles\n");
+    }
+}
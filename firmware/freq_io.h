@@ -0,0 +1,47 @@
+#ifndef FREQ_IO_H
+#define FREQ_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Frequency counter and edge timestamps on a user area pad read through
+// reg_mprj_datal / reg_mprj_datah (the pad must have its input enabled,
+// e.g. GPIO_MODE_MGMT_STD_INPUT_NOPULL or a *_MONITORED mode).
+//
+// The pad is polled from a loop in RAM, so a signal is only followed up
+// to half the poll rate (poll_hz below, a few hundred kHz at a 10 MHz
+// core clock);  faster clocks alias and must be divided down first.
+//
+//   freq_gate()   counts rising edges and high polls while counter-timer 0
+//                 runs down the gate time (one-shot)
+//   freq_edges()  records the rdcycle time of FREQ_EDGES consecutive
+//                 rising edges, for period and jitter statistics
+//
+// Counter-timer 0 is not free with time_timebase_start().
+
+#define FREQ_EDGES_LOG2		5
+#define FREQ_EDGES		((1 << FREQ_EDGES_LOG2) + 1)	// timestamps
+
+typedef struct {
+    uint32_t gate;	// gate time in cycles
+    // filled in by freq_gate()
+    uint32_t edges;	// rising edges in the gate
+    uint32_t polls;	// pad reads
+    uint32_t high;	// reads that found the pad high
+    uint32_t cycles;	// measured gate length
+} freq_gate_t;
+
+typedef struct {
+    uint32_t t[FREQ_EDGES];	// rising edge times (rdcycle)
+    uint32_t n;			// times recorded
+    // filled in by freq_stats()
+    uint32_t min, max;		// shortest and longest period
+    uint32_t mean;		// mean period (cycles, 4 fraction bits)
+    uint32_t mad;		// mean absolute deviation (4 fraction bits)
+} freq_edges_t;
+
+int freq_gate(uint32_t pad, freq_gate_t *g);
+int freq_edges(uint32_t pad, freq_edges_t *e, uint32_t timeout);
+int freq_stats(freq_edges_t *e);
+void freq_report(const freq_gate_t *g, const freq_edges_t *e);
+
+#endif // FREQ_IO_H
@@ -0,0 +1,81 @@
+#include "gpio_config_io.h"
+
+// The reg_mprj_io_N registers hold the configuration that the serial
+// transfer shifts out to the pads.  Writing them is cheap; the transfer is
+// not, so it is only started when at least one register changed.
+
+#define gpio_config_reg(pad) ((&reg_mprj_io_0)[pad])
+
+/*
+ * gpio_config_xfer()
+ * ----------------------------------------------------------------------------
+ * load the pad configuration registers into the pads
+ */
+void gpio_config_xfer()
+{
+    reg_mprj_xfer = 1;
+    while (reg_mprj_xfer == 1);
+}
+
+/*
+ * gpio_config()
+ * ----------------------------------------------------------------------------
+ * apply a configuration table:  write only the registers that differ,
+ * start one transfer if any did, then read back and verify.  The table is
+ * walked from the end so that each pad is compared once, with the last
+ * entry for it.  Returns the number of pads changed, or -1 if the
+ * readback does not match the table.
+ */
+int gpio_config(const gpio_config_t *table, int n)
+{
+    uint32_t seen[2] = {0, 0};
+    int changed = 0;
+
+    for (int i = n - 1; i >= 0; i--) {
+        uint32_t mode = table[i].mode;
+        for (uint32_t pad = table[i].first; pad <= table[i].last; pad++) {
+            uint32_t bit = 1 << (pad & 31);
+            if (seen[pad >> 5] & bit)
+                continue;
+            seen[pad >> 5] |= bit;
+            if ((gpio_config_reg(pad) & GPIO_MODE_MASK) != mode) {
+                gpio_config_reg(pad) = mode;
+                changed++;
+            }
+        }
+    }
+
+    if (changed)
+        gpio_config_xfer();
+
+    if (gpio_config_verify(table, n))
+        return -1;
+    return changed;
+}
+
+/*
+ * gpio_config_verify()
+ * ----------------------------------------------------------------------------
+ * compare the configuration registers with the table (the last entry for
+ * each pad wins); returns the number of mismatching pads
+ */
+int gpio_config_verify(const gpio_config_t *table, int n)
+{
+    uint32_t seen[2] = {0, 0};
+    int errors = 0;
+
+    for (int i = n - 1; i >= 0; i--) {
+        uint32_t mode = table[i].mode;
+        for (uint32_t pad = table[i].first; pad <= table[i].last; pad++) {
+            uint32_t bit = 1 << (pad & 31);
+            if (seen[pad >> 5] & bit)
+                continue;
+            seen[pad >> 5] |= bit;
+            if ((gpio_config_reg(pad) & GPIO_MODE_MASK) != mode)
+                errors++;
+        }
+    }
+    if (reg_mprj_xfer & 1)
+        errors++;
+    return errors;
+}
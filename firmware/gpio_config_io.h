@@ -0,0 +1,33 @@
+#ifndef GPIO_CONFIG_IO_H
+#define GPIO_CONFIG_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// User area pad configuration from a const table (kept in flash).  Each
+// entry sets pads first..last to one mode; later entries override earlier
+// ones.  Example:
+//
+//     static const gpio_config_t pads[] = {
+//         GPIO_PADS(5, 37, GPIO_MODE_MGMT_STD_OUTPUT),
+//         GPIO_PAD(6, 0x7ff),
+//     };
+//     gpio_config(pads, GPIO_CONFIG_LEN(pads));
+
+typedef struct {
+    uint8_t first;
+    uint8_t last;
+    uint16_t mode;
+} gpio_config_t;
+
+#define GPIO_PAD(pad, mode)		{(pad), (pad), (mode)}
+#define GPIO_PADS(first, last, mode)	{(first), (last), (mode)}
+#define GPIO_CONFIG_LEN(table)		(sizeof(table) / sizeof((table)[0]))
+
+#define GPIO_PAD_COUNT	38
+#define GPIO_MODE_MASK	0x1fff
+
+int gpio_config(const gpio_config_t *table, int n);
+int gpio_config_verify(const gpio_config_t *table, int n);
+void gpio_config_xfer();
+
+#endif // GPIO_CONFIG_IO_H
@@ -1,6 +1,13 @@
 //#include "../defs.h"
 #include "../defs_mpw-two-mfix.h"
 #include "../print_io.h"
+#include "../time_io.h"
+#include "../gpio_config_io.h"
+
+static const gpio_config_t gpio_test_pads[] = {
+    GPIO_PADS(36, 37, GPIO_MODE_MGMT_STD_OUTPUT),
+    GPIO_PADS(19, 33, GPIO_MODE_MGMT_STD_OUTPUT),
+};
 
 // --------------------------------------------------------
 // Firmware routines
@@ -8,32 +15,12 @@
 
 void main()
 {
-	int i, j;
+	int i;
 
 	i = 1;
 
-    // Left side I/O
-    reg_mprj_io_37 = 0x1808;
-    reg_mprj_io_36 = 0x1808;
-    reg_mprj_io_33 = 0x1808;
-    reg_mprj_io_32 = 0x1808;
-    reg_mprj_io_31 = 0x1808;
-    reg_mprj_io_30 = 0x1808;
-    reg_mprj_io_29 = 0x1808;
-    reg_mprj_io_28 = 0x1808;
-    reg_mprj_io_27 = 0x1808;
-    reg_mprj_io_26 = 0x1808;
-    reg_mprj_io_25 = 0x1808;
-
-    // Bank from 14 to 24 does not exist on Caravan projects!
-
-    reg_mprj_io_24 = 0x1808;
-    reg_mprj_io_23 = 0x1808;
-    reg_mprj_io_22 = 0x1808;
-    reg_mprj_io_21 = 0x1808;
-    reg_mprj_io_20 = 0x1808;
-    reg_mprj_io_19 = 0x1808;
-
+    // Left side I/O; bank from 14 to 24 does not exist on Caravan projects!
+    gpio_config(gpio_test_pads, GPIO_CONFIG_LEN(gpio_test_pads));
 
 //    reg_mprj_io_18 = 0x0000;
 //    reg_mprj_io_17 = 0x00c0;
@@ -57,9 +44,6 @@ void main()
 
     reg_mprj_datal = 0;
 
-    reg_mprj_xfer = 1;
-    while (reg_mprj_xfer == 1);
-
     // Reset right side I/O after transfer to the "intended" config
 //    reg_mprj_io_18 = 0x1808;
 //    reg_mprj_io_17 = 0x0403;
@@ -96,7 +80,7 @@ void main()
 
         reg_gpio_data = 0x0;
 
-        for (j = 0; j < 3000; j++);
+        delay_ms(150);
 
 //        reg_mprj_datal = 0x55555555;
 //       	reg_mprj_datah = 0x55555500;
@@ -109,7 +93,7 @@ void main()
         reg_gpio_data = 0x1;
 
 
-        for (j = 0; j < 3000; j++);
+        delay_ms(150);
 	}
 
 }
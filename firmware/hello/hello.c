@@ -1,8 +1,15 @@
 //#include "../defs.h"
 #include "../defs_mpw-two-mfix.h"
 #include "../print_io.h"
+#include "../time_io.h"
+#include "../gpio_config_io.h"
+#include "../lcd_io.h"
 //#include "spi_io.h"
 
+// Only pad 6 (UART TX) is changed from the housekeeping defaults
+static const gpio_config_t hello_pads[] = {
+    GPIO_PAD(6, 0x7ff),
+};
 
 // --------------------------------------------------------
 // Firmware routines
@@ -20,7 +27,7 @@ void clear_gpio(int pin)
 
 void main()
 {
-	int i, j, k;
+	int i;
 
 	i = 1;
 
@@ -68,15 +75,12 @@ void main()
 //    reg_mprj_io_2 = GPIO_MODE_USER_STD_INPUT_NOPULL;   // 0x0403
 //    reg_mprj_io_1 = GPIO_MODE_USER_STD_BIDIRECTIONAL;  // 0x1803
 
-    reg_mprj_io_6 = 0x7ff;
-
     reg_mprj_datal = 0;
 
     reg_uart_clkdiv = 1042;
     reg_uart_enable = 1;
 
-    reg_mprj_xfer = 1;
-    while (reg_mprj_xfer == 1);
+    gpio_config(hello_pads, GPIO_CONFIG_LEN(hello_pads));
 
 	// Enable GPIO (all output, ena = 0)
 	reg_gpio_ena = 0x0;
@@ -84,50 +88,6 @@ void main()
 	reg_gpio_pd = 0x0;
 	reg_gpio_data = 0x1;
 
-    reg_mprj_io_37 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_36 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_35 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_34 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_33 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_32 = GPIO_MODE_MGMT_STD_OUTPUT;
-
-    reg_mprj_io_31 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_30 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_29 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_28 = GPIO_MODE_MGMT_STD_OUTPUT;
-
-    reg_mprj_io_27 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_26 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_25 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_24 = GPIO_MODE_MGMT_STD_OUTPUT;
-
-    reg_mprj_io_23 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_22 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_21 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_20 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_19 = GPIO_MODE_MGMT_STD_OUTPUT;
-
-    reg_mprj_io_18 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_17 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_16 = GPIO_MODE_MGMT_STD_OUTPUT;
-
-    reg_mprj_io_15 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_14 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_13 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_12 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_11 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_10 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_9 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_8 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_7 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_6 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_5 = GPIO_MODE_MGMT_STD_OUTPUT;
-
-    reg_mprj_io_4 = GPIO_MODE_USER_STD_INPUT_NOPULL;
-    reg_mprj_io_3 = GPIO_MODE_USER_STD_INPUT_NOPULL;
-    reg_mprj_io_2 = GPIO_MODE_USER_STD_INPUT_NOPULL;   // 0x0403
-    reg_mprj_io_1 = GPIO_MODE_USER_STD_BIDIRECTIONAL;  // 0x1803
-
 //	reg_mprj_datal = 0x00000000;
 //	reg_mprj_datah = 0x00000000;
 
@@ -150,25 +110,29 @@ void main()
     putchar("|"); putchar(0x9e);
     putchar("|"); putchar(0xbc);
 
+    lcd_init();
+
 	while(1) {
-	    print("|"); putchar(0x2d); // clear screen
+	    lcd_clear();
+	    lcd_flush();
 
         for (i=0; i < 2; i++) {
             reg_gpio_data = 0x0;
-            for (j = 0; j < 3000; j++);
+            delay_ms(150);
             reg_gpio_data = 0x1;
-            for (j = 0; j < 5000; j++);
+            delay_ms(250);
         }
 
 	    for (i = 0; i < n; i++) {
-	        print(msg[i]);
-	        for (j = 0; j < 5000; j++);
+	        lcd_print(i, 0, msg[i]);
+	        lcd_flush();
+	        delay_ms(250);
 	        reg_gpio_data = 0x0;
-            for (j = 0; j < 5000; j++);
+            delay_ms(250);
 	        reg_gpio_data = 0x1;
 	    }
 
-        for (j = 0; j < 10000; j++);
+        delay_ms(500);
 
 //        for (i=0; i < 2; i++) {
 //            reg_gpio_data = 0x0;
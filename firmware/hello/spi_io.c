@@ -1,9 +1,10 @@
 #include "../defs_mpw-two-mfix.h"
 #include "spi_io.h"
+#include "../time_io.h"
 
 #define CS_PIN (uint32_t) (1 << 27) // bit 27
-#define SDI_PIN (uint32_t) (1 << 25) // bit 26
-#define SDO_PIN (uint32_t) (1 << 24) // bit 25
+#define SDI_PIN (uint32_t) (1 << 26) // bit 26
+#define SDO_PIN (uint32_t) (1 << 25) // bit 25
 #define SCK_PIN (uint32_t) (1 << 24) // bit 24
 
 //#define SDI_IN (volatile uint32_t) (reg_gpio_ena |= (SDI_PIN))
@@ -21,11 +22,7 @@
 
 void spi_delay()
 {
-//	for (int j = 0; j < 200000; j++);  // 1 secs
-//	for (int j = 0; j < 100000; j++);  // 0.5 secs
-	for (int j = 0; j < 100; j++);  // ~23 usec (measured)
-//	for (int j = 0; j < 2; j++);  // ~23 usec (measured)
-//	for (int j = 0; j < 1; j++);  // ~23 usec (measured)
+	delay_us(23);
 }
 
 void spi_init()
@@ -147,7 +144,7 @@ void read_spi_slave_bytes(volatile uint32_t slave_addr, volatile uint32_t *data,
     spi_start();
     spi_write(slave_addr | (uint32_t) 0x0001);  // addr + read mode
     for (i = 0; i < len-1; i++)
-	    data[i] = spi_read(true);
-	data[len-1] = spi_read(false);
+	    data[i] = spi_read();
+	data[len-1] = spi_read();
 	spi_stop();
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../irq_io.h"
+
+// Interrupt latency:  cycles from an IRQ to the first statement of its C
+// handler, through irq_vector (start.s) and irq_table[].
+//
+//   timer    the picorv32 timer, armed to fire TIMER_DELAY cycles after a
+//            cycle count is taken, with the core spinning or in waitirq
+//   user     user_irq[0] (IRQ_USER0), raised by the user project when the
+//            core sets LA bit 96 (the simulator's "irqloop" model);
+//            latency counted from the LA write
+
+#define RUNS_LOG2	4
+#define RUNS		(1 << RUNS_LOG2)
+#define TIMER_DELAY	400
+
+#define rdcycle(c) __asm__ volatile ("rdcycle %0" : "=r"(c))
+#define waitirq() __asm__ volatile (".insn r 0x0B, 4, 4, x0, x0, x0")
+
+static volatile uint32_t t_irq;
+static volatile uint32_t fired;
+
+typedef struct {
+    uint32_t min, max, sum;
+} lat_t;
+
+static void timer_isr(void)
+{
+    rdcycle(t_irq);
+    fired = 1;
+}
+
+static void user_isr(void)
+{
+    rdcycle(t_irq);
+    reg_la3_data = 0;
+    fired = 1;
+}
+
+static void lat_add(lat_t *l, uint32_t cycles)
+{
+    if (cycles < l->min)
+        l->min = cycles;
+    if (cycles > l->max)
+        l->max = cycles;
+    l->sum += cycles;
+}
+
+static void lat_print(const char *what, const lat_t *l)
+{
+    print_fmt("%-12s min %4u  avg %4u  max %4u cycles\n",
+              what, l->min, l->sum >> RUNS_LOG2, l->max);
+}
+
+// arm the timer right after reading the cycle counter
+static uint32_t timer_arm(void)
+{
+    uint32_t start;
+
+    fired = 0;
+    __asm__ volatile ("rdcycle %0\n\t.insn r 0x0B, 6, 5, x0, %1, x0"
+                      : "=&r"(start) : "r"(TIMER_DELAY));
+    return start + TIMER_DELAY;
+}
+
+void main()
+{
+    lat_t busy = {~0u, 0, 0}, sleep = {~0u, 0, 0}, user = {~0u, 0, 0};
+    uint32_t due, mask;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("irq_bench\n");
+
+    irq_attach(IRQ_TIMER, timer_isr);
+    irq_attach(IRQ_USER0, user_isr);
+    irq_enable(IRQ_TIMER);
+    irq_enable(IRQ_USER0);
+
+    for (uint32_t i = 0; i < RUNS; i++) {
+        due = timer_arm();
+        while (!fired)
+            ;
+        lat_add(&busy, t_irq - due);
+    }
+
+    // waitirq with the IRQs masked, then let the handler run
+    for (uint32_t i = 0; i < RUNS; i++) {
+        mask = irq_setmask(0xffffffff);
+        due = timer_arm();
+        waitirq();
+        irq_setmask(mask);
+        lat_add(&sleep, t_irq - due);
+    }
+
+    // LA bit 96 driven by the core, user_irq[0] passed to the core
+    reg_la3_data = 0;
+    reg_la3_oenb = reg_la3_iena = 0xFFFFFFFE;
+    irq_user_lines(1);
+    for (uint32_t i = 0; i < RUNS; i++) {
+        fired = 0;
+        rdcycle(due);
+        reg_la3_data = 1;
+        while (!fired)
+            ;
+        lat_add(&user, t_irq - due);
+    }
+    irq_user_lines(0);
+
+    lat_print("timer", &busy);
+    lat_print("timer wfi", &sleep);
+    lat_print("user irq 0", &user);
+}
@@ -0,0 +1,116 @@
+#include "irq_io.h"
+#include "print_io.h"
+
+// Handlers of drivers that may not be linked into every firmware
+void spimaster_irq() __attribute__((weak));
+void power_timer_irq() __attribute__((weak));
+
+// Handler of each IRQ line, called by irq_vector in start.s for every
+// pending IRQ (0 = none).  The drivers' handlers are set here; others are
+// set with irq_attach().
+irq_fn_t irq_table[IRQ_LINES] = {
+    [IRQ_TIMER] = uart_tx_irq,
+    [IRQ_SPI_MASTER] = spimaster_irq,
+    [IRQ_COUNTER_TIMER1] = power_timer_irq,
+};
+
+// picorv32 custom instructions (opcode custom-0), see the picorv32 README.
+// All IRQs are masked out of reset.
+
+/*
+ * irq_setmask()
+ * ----------------------------------------------------------------------------
+ * set the IRQ mask (1 = masked), returns the previous mask
+ */
+uint32_t irq_setmask(uint32_t mask)
+{
+    uint32_t old;
+    __asm__ volatile (".insn r 0x0B, 6, 3, %0, %1, x0" : "=r"(old) : "r"(mask));
+    return old;
+}
+
+/*
+ * irq_getmask()
+ * ----------------------------------------------------------------------------
+ * read the IRQ mask
+ */
+uint32_t irq_getmask()
+{
+    uint32_t mask = irq_setmask(0xffffffff);
+    irq_setmask(mask);
+    return mask;
+}
+
+/*
+ * irq_enable()
+ * ----------------------------------------------------------------------------
+ * unmask one IRQ line
+ */
+void irq_enable(uint32_t irq)
+{
+    uint32_t mask = irq_setmask(0xffffffff);
+    irq_setmask(mask & ~(1 << irq));
+}
+
+/*
+ * irq_disable()
+ * ----------------------------------------------------------------------------
+ * mask one IRQ line
+ */
+void irq_disable(uint32_t irq)
+{
+    uint32_t mask = irq_setmask(0xffffffff);
+    irq_setmask(mask | (1 << irq));
+}
+
+/*
+ * irq_timer()
+ * ----------------------------------------------------------------------------
+ * raise IRQ_TIMER after the given number of cycles (0 stops the timer),
+ * returns the cycles that were left on the timer
+ */
+uint32_t irq_timer(uint32_t cycles)
+{
+    uint32_t old;
+    __asm__ volatile (".insn r 0x0B, 6, 5, %0, %1, x0" : "=r"(old) : "r"(cycles));
+    return old;
+}
+
+/*
+ * irq_attach()
+ * ----------------------------------------------------------------------------
+ * set the handler of an IRQ line (0 to ignore it); enable the line with
+ * irq_enable()
+ */
+void irq_attach(uint32_t irq, irq_fn_t fn)
+{
+    uint32_t mask;
+
+    if (irq >= IRQ_LINES)
+        return;
+    mask = irq_setmask(0xffffffff);
+    irq_table[irq] = fn;
+    irq_setmask(mask);
+}
+
+/*
+ * irq_user_lines()
+ * ----------------------------------------------------------------------------
+ * pass the user project IRQ lines set in lines (bit n = IRQ_USER0 + n) to
+ * the core (reg_mprj_irq)
+ */
+void irq_user_lines(uint32_t lines)
+{
+    reg_mprj_irq = lines & 7;
+}
+
+/*
+ * irq_pad_sources()
+ * ----------------------------------------------------------------------------
+ * raise IRQ_GPIO7 / IRQ_GPIO8 from the user area pads (IRQ7_SOURCE,
+ * IRQ8_SOURCE in reg_irq_source)
+ */
+void irq_pad_sources(uint32_t sources)
+{
+    reg_irq_source = sources & (IRQ7_SOURCE | IRQ8_SOURCE);
+}
@@ -0,0 +1,36 @@
+#ifndef IRQ_IO_H
+#define IRQ_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// picorv32 IRQ lines in the management SoC
+#define IRQ_TIMER		0	// picorv32 internal timer (used by print_io)
+#define IRQ_EBREAK		1
+#define IRQ_BUSERROR		2
+#define IRQ_GPIO7		7	// see reg_irq_source
+#define IRQ_GPIO8		8
+#define IRQ_SPI_MASTER		9
+#define IRQ_COUNTER_TIMER0	10
+#define IRQ_COUNTER_TIMER1	11
+#define IRQ_USER0		12	// user project IRQs, see reg_mprj_irq
+#define IRQ_USER1		13
+#define IRQ_USER2		14
+
+#define IRQ_LINES		16	// slots in irq_table[]
+
+// Interrupt handlers are called from irq_vector (start.s) with IRQs off;
+// they must clear the source of their IRQ.
+typedef void (*irq_fn_t)(void);
+
+extern irq_fn_t irq_table[IRQ_LINES];
+
+uint32_t irq_setmask(uint32_t mask);
+uint32_t irq_getmask();
+void irq_enable(uint32_t irq);
+void irq_disable(uint32_t irq);
+uint32_t irq_timer(uint32_t cycles);
+void irq_attach(uint32_t irq, irq_fn_t fn);
+void irq_user_lines(uint32_t lines);
+void irq_pad_sources(uint32_t sources);
+
+#endif // IRQ_IO_H
@@ -0,0 +1,176 @@
+#include "la_capture_io.h"
+#include "print_io.h"
+#include "fmt_io.h"
+#include "time_io.h"
+#include "ramfunc.h"
+
+// The sampling loop runs from RAM so that its rate does not depend on
+// flash fetches.  Every iteration does the same work, so the sample period
+// is the loop cycles divided by the samples taken (given in the dump).
+
+#define la_data_reg(i) ((&reg_la0_data)[i])
+
+#define LA_NOT_TRIGGERED 0xffffffff
+
+// Sampling loop state, passed to the RAM loop as one pointer
+typedef struct {
+    volatile uint32_t *src[4];
+    uint32_t n;		// LA words per sample
+    uint32_t slot;	// position of the trigger word in a sample
+    uint32_t *buf;
+    uint32_t ring;	// ring size - 1
+    uint32_t shift;
+    const la_trigger_t *trig;
+    uint32_t at;	// sample number of the trigger
+} la_run_t;
+
+static uint32_t la_popcount(uint32_t words)
+{
+    uint32_t n = 0;
+
+    for (; words; words >>= 1)
+        n += words & 1;
+    return n;
+}
+
+/*
+ * la_capture_loop()
+ * ----------------------------------------------------------------------------
+ * sample into the ring until post samples from the trigger on are taken;
+ * returns the samples taken, or 0 if the trigger timed out
+ */
+RAMFUNC static uint32_t la_capture_loop(la_run_t *run)
+{
+    const la_trigger_t *t = run->trig;
+    uint32_t edges = t->rise | t->fall;
+    uint32_t prev = *run->src[run->slot];
+    uint32_t left = t->post ? t->post : 1;
+    uint32_t *d, v;
+
+    for (uint32_t i = 0; ; i++) {
+        d = run->buf + ((i & run->ring) << run->shift);
+        for (uint32_t k = 0; k < run->n; k++)
+            d[k] = *run->src[k];
+
+        if (run->at == LA_NOT_TRIGGERED) {
+            v = d[run->slot];
+            if ((v & t->mask) == t->value &&
+                (!edges || (~prev & v & t->rise) || (prev & ~v & t->fall)))
+                run->at = i;
+            else if (t->timeout && i + 1 == t->timeout)
+                return 0;
+            prev = v;
+        }
+        if (run->at != LA_NOT_TRIGGERED && --left == 0)
+            return i + 1;
+    }
+}
+
+/*
+ * la_capture_init()
+ * ----------------------------------------------------------------------------
+ * set up a capture of the LA words in the words mask into buf, a ring of
+ * size samples (a power of two, LA_CAPTURE_RING_WORDS(size, words) words)
+ */
+void la_capture_init(la_capture_t *cap, uint32_t *buf, uint32_t size, uint32_t words)
+{
+    uint32_t n = la_popcount(words & 0xf);
+
+    cap->buf = buf;
+    cap->size = size;
+    cap->words = words & 0xf;
+    cap->shift = n == 1 ? 0 : n == 2 ? 1 : 2;
+    cap->first = 0;
+    cap->count = 0;
+    cap->trigger = 0;
+    cap->taken = 0;
+    cap->cycles = 0;
+}
+
+/*
+ * la_capture()
+ * ----------------------------------------------------------------------------
+ * sample until the trigger fires and the post-trigger samples are taken.
+ * Returns 0, or -1 if the trigger timed out or does not fit the capture
+ * (trigger word not sampled, more post-trigger samples than the ring);
+ * pre-trigger samples are cut to what the ring holds.
+ */
+int la_capture(la_capture_t *cap, const la_trigger_t *trig)
+{
+    la_run_t run;
+    uint32_t pre = trig->pre;
+    uint32_t post = trig->post ? trig->post : 1;
+    uint32_t start, first;
+
+    if (!(cap->words & (1 << trig->trig_word)) || post > cap->size)
+        return -1;
+    if (pre > cap->size - post)
+        pre = cap->size - post;
+
+    run.n = 0;
+    run.slot = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        if (!(cap->words & (1 << i)))
+            continue;
+        if (i == trig->trig_word)
+            run.slot = run.n;
+        run.src[run.n++] = &la_data_reg(i);
+    }
+    run.buf = cap->buf;
+    run.ring = cap->size - 1;
+    run.shift = cap->shift;
+    run.trig = trig;
+    run.at = LA_NOT_TRIGGERED;
+
+    start = time_cycles();
+    cap->taken = la_capture_loop(&run);
+    cap->cycles = time_elapsed(start);
+    if (!cap->taken)
+        return -1;
+
+    first = run.at > pre ? run.at - pre : 0;
+    cap->first = first & run.ring;
+    cap->count = cap->taken - first;
+    cap->trigger = run.at - first;
+    return 0;
+}
+
+static void la_dump_run(const uint32_t *d, uint32_t n, uint32_t run)
+{
+    print_fmt("la %u", run);
+    for (uint32_t k = 0; k < n; k++)
+        print_fmt(" %08x", d[k]);
+    print("\n");
+}
+
+/*
+ * la_capture_dump()
+ * ----------------------------------------------------------------------------
+ * print the kept samples over the UART, oldest first, as runs of equal
+ * samples:  a header line, "la <count> <word> ..." per run, "la end"
+ */
+void la_capture_dump(const la_capture_t *cap)
+{
+    uint32_t n = la_popcount(cap->words);
+    const uint32_t *d, *prev = 0;
+    uint32_t run = 0, k;
+
+    print_fmt("la capture words %x samples %u trigger %u taken %u cycles %u\n",
+              cap->words, cap->count, cap->trigger, cap->taken, cap->cycles);
+    for (uint32_t i = 0; i < cap->count; i++) {
+        d = cap->buf + (((cap->first + i) & (cap->size - 1)) << cap->shift);
+        if (prev) {
+            for (k = 0; k < n && d[k] == prev[k]; k++);
+            if (k == n) {
+                run++;
+                continue;
+            }
+            la_dump_run(prev, n, run);
+        }
+        prev = d;
+        run = 1;
+    }
+    if (prev)
+        la_dump_run(prev, n, run);
+    print("la end\n");
+}
@@ -0,0 +1,57 @@
+#ifndef LA_CAPTURE_IO_H
+#define LA_CAPTURE_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Logic analyzer capture:  samples the selected LA words (reg_la<i>_data,
+// the user project side of bits with oenb = 1) into a RAM ring buffer as
+// fast as the capture loop runs, stops a set number of samples after a
+// trigger and dumps the run-length compressed samples over the UART for
+// util/la_dump2vcd.py.  Example (trigger on a rising LA bit 118):
+//
+//     static uint32_t ring[LA_CAPTURE_RING_WORDS(32, 2)];
+//     static const la_trigger_t trig = {
+//         .words = 0x9, .trig_word = 3, .rise = 1 << (118 - 96),
+//         .pre = 8, .post = 24, .timeout = 100000,
+//     };
+//     la_capture_t cap;
+//
+//     la_capture_init(&cap, ring, 32, trig.words);
+//     if (la_capture(&cap, &trig) == 0)
+//         la_capture_dump(&cap);
+
+typedef struct {
+    uint32_t words;	// LA words sampled:  bit i = reg_la<i>_data
+    uint32_t trig_word;	// LA word the trigger looks at (one of words)
+    uint32_t mask;	// trigger when (word & mask) == value
+    uint32_t value;
+    uint32_t rise;	// and, if rise or fall is set, one of the rise bits
+    uint32_t fall;	// went 0 -> 1 or one of the fall bits went 1 -> 0
+    uint32_t pre;	// samples kept from before the trigger
+    uint32_t post;	// samples from the trigger on (at least 1)
+    uint32_t timeout;	// samples to wait for the trigger, 0 = forever
+} la_trigger_t;
+
+// Ring buffer words for samples (a power of two) of the given number of
+// LA words (3 words take 4 slots)
+#define LA_CAPTURE_RING_WORDS(samples, words) \
+    ((samples) * ((words) == 1 ? 1 : (words) == 2 ? 2 : 4))
+
+typedef struct {
+    uint32_t *buf;
+    uint32_t size;	// ring size in samples
+    uint32_t words;	// LA words sampled
+    uint32_t shift;	// log2 of the ring words per sample
+    // filled in by la_capture()
+    uint32_t first;	// ring index of the oldest sample kept
+    uint32_t count;	// samples kept
+    uint32_t trigger;	// trigger sample, counted from the oldest kept
+    uint32_t taken;	// samples taken in all, kept or not
+    uint32_t cycles;	// cycles the sampling loop ran
+} la_capture_t;
+
+void la_capture_init(la_capture_t *cap, uint32_t *buf, uint32_t size, uint32_t words);
+int la_capture(la_capture_t *cap, const la_trigger_t *trig);
+void la_capture_dump(const la_capture_t *cap);
+
+#endif // LA_CAPTURE_IO_H
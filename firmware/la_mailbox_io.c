@@ -0,0 +1,120 @@
+#include "la_mailbox_io.h"
+#include "ramfunc.h"
+
+// One transfer loop for both directions runs from RAM, a single beat per
+// iteration so that it stays small (RAM is shared with the stack), and
+// the words go out at the rate the user project answers the handshake.
+
+#define la_mbox_tx	((&reg_la0_data)[LA_MBOX_TX_WORD])
+#define la_mbox_rx	((&reg_la0_data)[LA_MBOX_RX_WORD])
+#define la_mbox_ctl	((&reg_la0_data)[LA_MBOX_CTL_WORD])
+
+#define la_mbox_oenb(i)	((&reg_la0_oenb)[i])
+#define la_mbox_iena(i)	((&reg_la0_iena)[i])
+
+// TX_ACK and RX_REQ sit 16 bits above TX_REQ and RX_ACK
+#define LA_MBOX_IN_SHIFT	16
+
+// handshake outputs as last written
+static uint32_t la_mbox_out;
+
+// the word before is taken once TX_ACK is back equal to TX_REQ
+#define la_mbox_tx_free() \
+    !(((la_mbox_ctl >> LA_MBOX_IN_SHIFT) ^ out) & LA_MBOX_TX_REQ)
+
+#define la_mbox_rx_full() \
+    (((la_mbox_ctl >> LA_MBOX_IN_SHIFT) ^ out) & LA_MBOX_RX_ACK)
+
+/*
+ * la_mbox_move()
+ * ----------------------------------------------------------------------------
+ * the transfer loop of both directions:  for each word wait until the
+ * lane of bit is ready, move the word and toggle bit.  free is bit for TX
+ * (ready once ACK is back equal to REQ) and 0 for RX (ready while REQ
+ * differs from ACK).  Returns the words moved, fewer than n if a wait
+ * took LA_MBOX_SPIN polls.
+ */
+static RAMFUNC uint32_t la_mbox_move(uint32_t *buf, uint32_t n, uint32_t bit, uint32_t free)
+{
+    uint32_t out = la_mbox_out;
+    uint32_t i, spin;
+
+    for (i = 0; i < n; i++) {
+        for (spin = LA_MBOX_SPIN; !(((la_mbox_ctl >> LA_MBOX_IN_SHIFT) ^ out ^ free) & bit); )
+            if (--spin == 0)
+                goto timeout;
+        if (free)
+            la_mbox_tx = buf[i];
+        else
+            buf[i] = la_mbox_rx;
+        out ^= bit;
+        la_mbox_ctl = out;
+    }
+timeout:
+    la_mbox_out = out;
+    return i;
+}
+
+/*
+ * la_mbox_init()
+ * ----------------------------------------------------------------------------
+ * set the LA directions for the mailbox and take up the handshake state
+ * of the user side, so that nothing is pending
+ */
+void la_mbox_init(void)
+{
+    uint32_t in;
+
+    la_mbox_oenb(LA_MBOX_TX_WORD) = la_mbox_iena(LA_MBOX_TX_WORD) = 0;
+    la_mbox_oenb(LA_MBOX_RX_WORD) = la_mbox_iena(LA_MBOX_RX_WORD) = 0xFFFFFFFF;
+    la_mbox_oenb(LA_MBOX_CTL_WORD) = la_mbox_iena(LA_MBOX_CTL_WORD) =
+        ~(LA_MBOX_TX_REQ | LA_MBOX_RX_ACK);
+
+    in = la_mbox_ctl >> LA_MBOX_IN_SHIFT;
+    la_mbox_out = in & (LA_MBOX_TX_REQ | LA_MBOX_RX_ACK);
+    la_mbox_ctl = la_mbox_out;
+}
+
+/*
+ * la_mbox_send()
+ * ----------------------------------------------------------------------------
+ * send n words and wait for the last one to be taken; returns the words
+ * taken, less than n if the user side stopped answering
+ */
+uint32_t la_mbox_send(const uint32_t *buf, uint32_t n)
+{
+    uint32_t out, spin;
+    uint32_t sent = la_mbox_move((uint32_t *) buf, n, LA_MBOX_TX_REQ, LA_MBOX_TX_REQ);
+
+    // a word left on the lane by a timeout was not taken
+    if (sent < n)
+        return sent ? sent - 1 : 0;
+    out = la_mbox_out;
+    for (spin = LA_MBOX_SPIN; !la_mbox_tx_free(); )
+        if (--spin == 0)
+            return n ? n - 1 : 0;
+    return n;
+}
+
+/*
+ * la_mbox_recv()
+ * ----------------------------------------------------------------------------
+ * receive n words into buf; returns the words received, less than n if
+ * the user side had no more to send
+ */
+uint32_t la_mbox_recv(uint32_t *buf, uint32_t n)
+{
+    return la_mbox_move(buf, n, LA_MBOX_RX_ACK, 0);
+}
+
+/*
+ * la_mbox_rx_ready()
+ * ----------------------------------------------------------------------------
+ * 1 if an RX word is waiting
+ */
+int la_mbox_rx_ready(void)
+{
+    uint32_t out = la_mbox_out;
+
+    return la_mbox_rx_full() ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+#ifndef LA_MAILBOX_IO_H
+#define LA_MAILBOX_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Logic analyzer mailbox:  a 32-bit streaming channel in each direction
+// between the management core and the user project over the LA bits.
+//
+//   LA word 0  (LA_MBOX_TX_WORD)   TX data, management -> user
+//   LA word 1  (LA_MBOX_RX_WORD)   RX data, user -> management
+//   LA word 2  (LA_MBOX_CTL_WORD)  handshake:
+//       bit 0   TX_REQ  out   toggled when a new TX word is on the lane
+//       bit 1   RX_ACK  out   toggled when the RX word has been read
+//       bit 16  TX_ACK  in    set equal to TX_REQ once the word is taken
+//       bit 17  RX_REQ  in    toggled when a new RX word is on the lane
+//   LA word 3  free for the user project
+//
+// The handshake is two-phase:  a word is pending while REQ != ACK, so
+// every word costs one LA write each way and no return-to-zero.  The
+// user side must present the RX data no later than it toggles RX_REQ and
+// take the TX data no earlier than it sees TX_REQ toggle.  A send or
+// receive waits at most LA_MBOX_SPIN polls for the other side; a TX word
+// left pending by a timeout can still be taken later (la_mbox_init()
+// drops it).
+//
+//     la_mbox_init();
+//     la_mbox_send(frame, 64);
+//     n = la_mbox_recv(result, 16);
+
+#define LA_MBOX_TX_WORD		0
+#define LA_MBOX_RX_WORD		1
+#define LA_MBOX_CTL_WORD	2
+
+#define LA_MBOX_TX_REQ		0x00000001
+#define LA_MBOX_RX_ACK		0x00000002
+#define LA_MBOX_TX_ACK		0x00010000
+#define LA_MBOX_RX_REQ		0x00020000
+
+#define LA_MBOX_SPIN		100000
+
+void la_mbox_init(void);
+uint32_t la_mbox_send(const uint32_t *buf, uint32_t n);
+uint32_t la_mbox_recv(uint32_t *buf, uint32_t n);
+int la_mbox_rx_ready(void);
+
+#endif // LA_MAILBOX_IO_H
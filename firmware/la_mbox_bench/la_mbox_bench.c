@@ -0,0 +1,78 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../la_mailbox_io.h"
+
+// LA mailbox throughput:  blocks of BLOCK_WORDS words are sent to the user
+// project and read back (the simulator's "mailbox" model loops them back),
+// checked, and the send, receive and round-trip rates compared with
+// word-at-a-time wishbone writes and reads at 0x3000_0000.
+
+#define BLOCK_LOG2	5
+#define BLOCK_WORDS	(1 << BLOCK_LOG2)
+#define ROUNDS_LOG2	3
+#define ROUNDS		(1 << ROUNDS_LOG2)
+
+static uint32_t tx[BLOCK_WORDS];
+static uint32_t rx[BLOCK_WORDS];
+
+// write and read back the block one word at a time over the wishbone bus
+static uint32_t wb_block(void)
+{
+    volatile uint32_t *wb = &reg_mprj_slave;
+    uint32_t start = time_cycles();
+
+    for (uint32_t i = 0; i < BLOCK_WORDS; i++)
+        *wb = tx[i];
+    for (uint32_t i = 0; i < BLOCK_WORDS; i++)
+        rx[i] = *wb;
+    return time_elapsed(start);
+}
+
+static void report(const char *what, uint32_t words, uint32_t cycles)
+{
+    print_fmt("%-10s %6u B/s  ", what, time_rate(words << 2, cycles));
+    print_fixed(cycles, BLOCK_LOG2 + ROUNDS_LOG2, 1);
+    print(" cycles/word\n");
+}
+
+void main()
+{
+    uint32_t start, t_send = 0, t_recv = 0, t_wb = 0;
+    uint32_t sent = 0, got = 0, errors = 0, seed = 0x1234567;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("la_mbox_bench\n");
+    la_mbox_init();
+
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        for (uint32_t i = 0; i < BLOCK_WORDS; i++) {
+            seed = (seed << 1) ^ (seed & 0x80000000 ? 0x04c11db7 : 0);
+            tx[i] = seed;
+            rx[i] = 0;
+        }
+
+        start = time_cycles();
+        sent += la_mbox_send(tx, BLOCK_WORDS);
+        t_send += time_elapsed(start);
+
+        start = time_cycles();
+        got += la_mbox_recv(rx, BLOCK_WORDS);
+        t_recv += time_elapsed(start);
+
+        for (uint32_t i = 0; i < BLOCK_WORDS; i++)
+            if (rx[i] != tx[i])
+                errors++;
+
+        t_wb += wb_block();
+    }
+
+    print_fmt("%u words sent %u received %u errors\n", sent, got, errors);
+    report("send", sent, t_send);
+    report("receive", got, t_recv);
+    report("round trip", sent, t_send + t_recv);
+    report("wishbone", ROUNDS * BLOCK_WORDS, t_wb);
+}
@@ -0,0 +1,44 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../la_capture_io.h"
+
+// On-chip logic analyzer:  captures LA words from the user project around
+// a trigger and dumps them over the UART for util/la_dump2vcd.py.  Edit
+// the trigger below to probe other signals.
+
+#define SCOPE_SAMPLES	32
+
+static const la_trigger_t trig = {
+    .words = 0x9,		// LA words 0 and 3
+    .trig_word = 3,
+    .rise = 1 << (118 - 96),	// Wakey Wakey wake output
+    .pre = 8,
+    .post = 24,
+    .timeout = 100000,
+};
+
+static uint32_t ring[LA_CAPTURE_RING_WORDS(SCOPE_SAMPLES, 2)];
+
+void main()
+{
+    la_capture_t cap;
+    la_trigger_t now;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    // sampled words are inputs from the user project
+    reg_la0_oenb = reg_la0_iena = 0xFFFFFFFF;
+    reg_la3_oenb = reg_la3_iena = 0xFFFFFFFF;
+
+    print("la_scope\n");
+    la_capture_init(&cap, ring, SCOPE_SAMPLES, trig.words);
+    if (la_capture(&cap, &trig) != 0) {
+        // no trigger:  show what the signals are doing anyway
+        print("trigger timeout, capturing now\n");
+        now = trig;
+        now.mask = now.value = now.rise = now.fall = 0;
+        la_capture(&cap, &now);
+    }
+    la_capture_dump(&cap);
+}
@@ -0,0 +1,119 @@
+#include "la_vector_io.h"
+#include "ramfunc.h"
+
+// Only the step itself runs from RAM:  la_vec_play() reads each record
+// from flash into a step descriptor and then calls la_vec_step(), which
+// waits for the slot, samples and applies it.  Flash fetches only shorten
+// the wait and do not move the step edges, and the RAM code stays small.
+
+#define la_data_reg(i) ((&reg_la0_data)[i])
+#define la_oenb_reg(i) ((&reg_la0_oenb)[i])
+#define la_iena_reg(i) ((&reg_la0_iena)[i])
+
+// Step descriptor, passed to the RAM step as one pointer
+typedef struct {
+    uint32_t period;
+    uint32_t late;
+    uint32_t sample[4];		// LA words sampled, in order
+    uint32_t ns;
+    uint32_t *resp;		// next response word
+    uint32_t *resp_end;
+    uint32_t drive[4];		// LA words driven, in order
+    uint32_t nd;		// words to apply in this step, 0 on repeats
+    uint32_t oe;		// LA_VEC_OE if oenb is applied too
+    uint32_t data[4];
+    uint32_t oenb[4];
+} la_vec_step_t;
+
+// rdcycle inline:  a call to time_cycles() would fetch from flash
+#define la_vec_rdcycle(cycles) __asm__ volatile ("rdcycle %0" : "=r"(cycles))
+
+/*
+ * la_vec_step()
+ * ----------------------------------------------------------------------------
+ * wait for the step slot at next, count it if it had already started,
+ * sample the response words if there is room and apply the step
+ */
+RAMFUNC static void la_vec_step(la_vec_step_t *s, uint32_t next)
+{
+    uint32_t now, k;
+
+    if (s->period) {
+        la_vec_rdcycle(now);
+        if ((int32_t) (now - next) > 0)
+            s->late++;
+        while ((int32_t) (now - next) < 0)
+            la_vec_rdcycle(now);
+    }
+    if (s->resp + s->ns <= s->resp_end)
+        for (k = 0; k < s->ns; k++)
+            *s->resp++ = la_data_reg(s->sample[k]);
+    if (s->oe)
+        for (k = 0; k < s->nd; k++)
+            la_oenb_reg(s->drive[k]) = la_iena_reg(s->drive[k]) = s->oenb[k];
+    for (k = 0; k < s->nd; k++)
+        la_data_reg(s->drive[k]) = s->data[k];
+}
+
+/*
+ * la_vec_play()
+ * ----------------------------------------------------------------------------
+ * play a vector file; returns 0, or -1 if vec is not a vector file.  The
+ * output enables of the driven LA words are left as the last record set.
+ */
+int la_vec_play(const uint32_t *vec, la_vec_run_t *run)
+{
+    la_vec_step_t s;
+    const uint32_t *src = vec + LA_VEC_HEADER;
+    uint32_t nd = 0, ctrl, rep, k, start, next;
+
+    run->steps = 0;
+    run->late = 0;
+    run->sampled = 0;
+    run->cycles = 0;
+    if (vec[0] != LA_VEC_MAGIC)
+        return -1;
+
+    s.period = run->period;
+    s.late = 0;
+    s.ns = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        if (vec[2] & (1 << i))
+            s.drive[nd++] = i;
+        if (vec[2] & (0x10 << i))
+            s.sample[s.ns++] = i;
+    }
+    if (!run->resp)
+        s.ns = 0;
+    s.resp = run->resp;
+    s.resp_end = run->resp + run->resp_len;
+
+    // the first step starts one period in, after its record is read
+    la_vec_rdcycle(start);
+    start += run->period;
+    next = start;
+    for (uint32_t r = 0; r < vec[1]; r++) {
+        ctrl = *src++;
+        for (k = 0; k < nd; k++)
+            s.data[k] = *src++;
+        s.oe = ctrl & LA_VEC_OE;
+        if (s.oe)
+            for (k = 0; k < nd; k++)
+                s.oenb[k] = *src++;
+        s.nd = nd;
+
+        rep = ctrl & LA_VEC_REPEAT_MASK;
+        do {
+            la_vec_step(&s, next);
+            s.nd = 0;
+            next += run->period;
+            run->steps++;
+        } while (rep-- > 1);
+    }
+    la_vec_step(&s, next);
+    la_vec_rdcycle(next);
+    run->cycles = next - start;
+    run->late = s.late;
+    run->sampled = s.resp - run->resp;
+    return 0;
+}
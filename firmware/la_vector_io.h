@@ -0,0 +1,41 @@
+#ifndef LA_VECTOR_IO_H
+#define LA_VECTOR_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Logic analyzer vector player:  drives test vectors compiled by
+// util/la_vec_compile.py from flash onto the LA outputs, one step every
+// period cycles (measured with rdcycle from the start of the run), and can
+// sample response words into RAM at every step.
+//
+// A vector file is made of little-endian words:
+//
+//   header   magic, records, LA words driven [3:0] and sampled [7:4],
+//            steps (all repeats added up)
+//   records  control word (repeat count [23:0], LA_VEC_OE if output
+//            enables follow), one data word per driven LA word, then
+//            one oenb word per driven LA word if LA_VEC_OE is set
+//
+// The responses are sampled at the start of every step, before its vector
+// is applied, and once more one period after the last step, so sample
+// n + 1 is the response to step n.
+
+#define LA_VEC_MAGIC		0x3156414c	// "LAV1"
+#define LA_VEC_HEADER		4
+#define LA_VEC_OE		0x80000000
+#define LA_VEC_REPEAT_MASK	0x00ffffff
+
+typedef struct {
+    uint32_t period;	// cycles per step, 0 = as fast as the loop runs
+    uint32_t *resp;	// response samples (LA words in order), or 0
+    uint32_t resp_len;	// room at resp, in words
+    // filled in by la_vec_play()
+    uint32_t steps;	// steps played
+    uint32_t late;	// steps that started after their slot
+    uint32_t sampled;	// response words stored
+    uint32_t cycles;	// cycles from the first to the last sample
+} la_vec_run_t;
+
+int la_vec_play(const uint32_t *vec, la_vec_run_t *run);
+
+#endif // LA_VECTOR_IO_H
@@ -0,0 +1,36 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../la_vector_io.h"
+
+// LA vector player:  drives the vectors compiled from vectors.txt into
+// the user project at a fixed step period and prints the sampled
+// responses.  Change VECTORS in the Makefile to play other vectors.
+
+#define STEP_CYCLES	200
+#define RESP_WORDS	32	// vectors.txt:  27 steps, 28 samples
+
+extern const uint32_t la_vectors[];
+
+static uint32_t resp[RESP_WORDS];
+
+void main()
+{
+    la_vec_run_t run = {
+        .period = STEP_CYCLES,
+        .resp = resp,
+        .resp_len = RESP_WORDS,
+    };
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("la_vectors\n");
+    if (la_vec_play(la_vectors, &run) != 0) {
+        print("no vector file\n");
+        return;
+    }
+    print_fmt("steps %u late %u cycles %u\n", run.steps, run.late, run.cycles);
+    for (uint32_t i = 0; i < run.sampled; i++)
+        print_fmt("resp %u %08x\n", i, resp[i]);
+}
@@ -0,0 +1,204 @@
+#include "lcd_io.h"
+#include "print_io.h"
+#include "fmt_io.h"
+#include "time_io.h"
+
+#define LCD_CELLS	(LCD_COLS * LCD_ROWS)
+
+// Rewrite up to this many unchanged cells rather than send a 2-byte
+// cursor move to skip them
+#define LCD_GAP		2
+
+// cursor position not known (after a row end, a clear or a redraw)
+#define LCD_NOWHERE	LCD_CELLS
+
+static char lcd_fb[LCD_CELLS];
+static char lcd_shown[LCD_CELLS];	// 0 = not known
+static uint32_t lcd_cursor;
+static uint32_t lcd_next;		// earliest time of the next refresh
+static uint32_t lcd_partial;		// last refresh ran out of bytes
+
+// framebuffer index and display (DDRAM) address of the first cell of a row
+static const uint8_t lcd_row_cell[LCD_ROWS] = {0, LCD_COLS, 2 * LCD_COLS, 3 * LCD_COLS};
+static const uint8_t lcd_row_addr[LCD_ROWS] = {0x00, 0x40, 0x14, 0x54};
+
+/*
+ * lcd_update()
+ * ----------------------------------------------------------------------------
+ * send the changed cells, at most budget bytes; returns the bytes sent
+ */
+static uint32_t lcd_update(uint32_t budget)
+{
+    uint32_t sent = 0, cell, col, row, gap;
+
+    lcd_partial = 0;
+    for (row = 0; row < LCD_ROWS; row++) {
+        cell = lcd_row_cell[row];
+        for (col = 0; col < LCD_COLS; col++, cell++) {
+            if (lcd_fb[cell] == lcd_shown[cell])
+                continue;
+
+            gap = cell - lcd_cursor;
+            if (lcd_cursor >= lcd_row_cell[row] && lcd_cursor < cell && gap <= LCD_GAP) {
+                // the cells in between are unchanged:  resend them
+                if (sent + gap + 1 > budget)
+                    goto out;
+                for (; lcd_cursor < cell; lcd_cursor++)
+                    putchar(lcd_fb[lcd_cursor]);
+                sent += gap;
+            } else if (lcd_cursor != cell) {
+                if (sent + 3 > budget)
+                    goto out;
+                putchar(LCD_COMMAND);
+                putchar(LCD_SET_ADDR | (lcd_row_addr[row] + col));
+                sent += 2;
+            } else if (sent + 1 > budget) {
+                goto out;
+            }
+
+            putchar(lcd_fb[cell]);
+            lcd_shown[cell] = lcd_fb[cell];
+            sent++;
+            // the display does not wrap to the next row in order
+            lcd_cursor = col == LCD_COLS - 1 ? LCD_NOWHERE : cell + 1;
+        }
+    }
+    return sent;
+
+out:
+    lcd_partial = 1;
+    return sent;
+}
+
+/*
+ * lcd_init()
+ * ----------------------------------------------------------------------------
+ * clear the display and the framebuffer
+ */
+void lcd_init(void)
+{
+    putchar(LCD_SETTING);
+    putchar(LCD_CLEAR);
+    for (uint32_t i = 0; i < LCD_CELLS; i++)
+        lcd_fb[i] = lcd_shown[i] = ' ';
+    lcd_cursor = LCD_NOWHERE;
+    lcd_partial = 0;
+    lcd_next = time_cycles();
+}
+
+/*
+ * lcd_clear()
+ * ----------------------------------------------------------------------------
+ * blank the framebuffer (the display follows at the next refresh)
+ */
+void lcd_clear(void)
+{
+    for (uint32_t i = 0; i < LCD_CELLS; i++)
+        lcd_fb[i] = ' ';
+}
+
+/*
+ * lcd_redraw()
+ * ----------------------------------------------------------------------------
+ * forget what the display shows, so the next refresh sends every cell
+ */
+void lcd_redraw(void)
+{
+    for (uint32_t i = 0; i < LCD_CELLS; i++)
+        lcd_shown[i] = 0;
+    lcd_cursor = LCD_NOWHERE;
+}
+
+/*
+ * lcd_print()
+ * ----------------------------------------------------------------------------
+ * write s into the framebuffer from row, col, cut at the end of the row.
+ * Control characters, '|' (the SerLCD setting prefix) and codes from 0x7f
+ * up (0xfe is the command prefix) show as spaces.
+ */
+void lcd_print(uint32_t row, uint32_t col, const char *s)
+{
+    char *d;
+    uint8_t c;
+
+    if (row >= LCD_ROWS)
+        return;
+    d = lcd_fb + lcd_row_cell[row];
+    for (; *s && col < LCD_COLS; s++, col++) {
+        c = *s;
+        d[col] = (c < ' ' || c >= 0x7f || c == LCD_SETTING) ? ' ' : c;
+    }
+}
+
+static void lcd_print_buf(uint32_t row, uint32_t col, char *buf, int len, uint32_t width)
+{
+    char *d;
+    uint32_t n = len;
+
+    if (row >= LCD_ROWS)
+        return;
+    d = lcd_fb + lcd_row_cell[row];
+    for (; n < width && col < LCD_COLS; n++, col++)
+        d[col] = ' ';
+    for (int i = 0; i < len && col < LCD_COLS; i++, col++)
+        d[col] = buf[i];
+}
+
+/*
+ * lcd_print_dec()
+ * ----------------------------------------------------------------------------
+ * write v right-aligned in width cells (at least its digits); if the
+ * digits do not fit before the end of the row, the cells left show '#'
+ * instead of a cut-down, wrong number
+ */
+void lcd_print_dec(uint32_t row, uint32_t col, uint32_t v, uint32_t width)
+{
+    char buf[FMT_U32_LEN];
+    int len = fmt_u32(buf, v);
+
+    if (col < LCD_COLS && len > LCD_COLS - col) {
+        len = LCD_COLS - col;
+        for (int i = 0; i < len; i++)
+            buf[i] = '#';
+    }
+    lcd_print_buf(row, col, buf, len, width);
+}
+
+void lcd_print_hex(uint32_t row, uint32_t col, uint32_t v, int digits)
+{
+    char buf[8];
+
+    if (digits > 8)
+        digits = 8;
+    lcd_print_buf(row, col, buf, fmt_hex(buf, v, digits), 0);
+}
+
+/*
+ * lcd_refresh()
+ * ----------------------------------------------------------------------------
+ * bring the display up to date with the framebuffer if LCD_REFRESH_US
+ * have passed since the last refresh (or that one was cut short); returns
+ * the bytes sent
+ */
+uint32_t lcd_refresh(void)
+{
+    uint32_t sent;
+
+    if (!lcd_partial && !time_expired(lcd_next))
+        return 0;
+    sent = lcd_update(LCD_REFRESH_BYTES);
+    if (!lcd_partial)
+        lcd_next = time_deadline_us(LCD_REFRESH_US);
+    return sent;
+}
+
+/*
+ * lcd_flush()
+ * ----------------------------------------------------------------------------
+ * send every change now, whatever the interval
+ */
+void lcd_flush(void)
+{
+    lcd_update(0xffffffff);
+    lcd_next = time_deadline_us(LCD_REFRESH_US);
+}
@@ -0,0 +1,46 @@
+#ifndef LCD_IO_H
+#define LCD_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Serial character LCD (SparkFun SerLCD, 20x4, on the UART TX pad) with an
+// in-RAM framebuffer.  Text is written into the framebuffer;  lcd_refresh()
+// sends only the cells that differ from what the display shows, moving the
+// cursor with a set-address command where that is shorter than rewriting
+// the cells in between.  Refreshes are at least LCD_REFRESH_US apart and
+// send at most LCD_REFRESH_BYTES, so with uart_tx_async(1) a refresh fits
+// the UART buffer and returns at once;  a frame cut short is finished by
+// the following calls without waiting for the interval.
+//
+//     lcd_init();
+//     lcd_print(0, 0, "loops");
+//     while (1) {
+//         lcd_print_dec(0, 10, n++, 6);
+//         lcd_refresh();
+//     }
+//
+// Anything else printed over the UART also lands on the display;  call
+// lcd_redraw() afterwards to have the next refresh resend every cell.
+
+#define LCD_COLS		20
+#define LCD_ROWS		4
+
+#define LCD_REFRESH_US		100000
+#define LCD_REFRESH_BYTES	48	// below the 64-byte UART buffer
+
+// SerLCD command prefixes
+#define LCD_SETTING		'|'	// '|' 0x2d:  clear display
+#define LCD_CLEAR		0x2d
+#define LCD_COMMAND		0xfe	// 0xfe 0x80 | addr:  set cursor
+#define LCD_SET_ADDR		0x80
+
+void lcd_init(void);
+void lcd_clear(void);
+void lcd_redraw(void);
+void lcd_print(uint32_t row, uint32_t col, const char *s);
+void lcd_print_dec(uint32_t row, uint32_t col, uint32_t v, uint32_t width);
+void lcd_print_hex(uint32_t row, uint32_t col, uint32_t v, int digits);
+uint32_t lcd_refresh(void);
+void lcd_flush(void);
+
+#endif // LCD_IO_H
@@ -53,7 +53,11 @@ void main()
 //		reg_gpio_data = 0;
 //	}
 
-while (1) {}
+	// nothing left to do:  stop in waitirq (picorv32) with every IRQ
+	// masked rather than spin fetching from flash (see power_io.c)
+	__asm__ volatile (".insn r 0x0B, 6, 3, x0, %0, x0" : : "r"(0xffffffff));
+	while (1)
+		__asm__ volatile (".insn r 0x0B, 4, 4, x0, x0, x0");
 
 //	while (1) {
 //		/* Slow blink for demonstration board */
@@ -0,0 +1,121 @@
+#include "pdm_io.h"
+#include "print_io.h"
+#include "fmt_io.h"
+#include "ramfunc.h"
+
+#define PDM_CLK		(1 << (PDM_CLK_PAD - 32))
+#define PDM_DATA_SHIFT	(PDM_DATA_PAD - 32)
+
+#define PDM_DUMP_LINE	16	// PCM samples per dump line
+
+/*
+ * pdm_dec_init()
+ * ----------------------------------------------------------------------------
+ * start a decimator from silence (all history zero)
+ */
+void pdm_dec_init(pdm_dec_t *d)
+{
+    d->p = 0;
+    d->m = 0;
+    d->i1 = 0;
+    d->i2 = 0;
+    d->c1 = 0;
+    d->c2 = 0;
+    d->phase = 0;
+}
+
+/*
+ * pdm_decimate()
+ * ----------------------------------------------------------------------------
+ * run words PDM words through the decimator; writes one PCM sample every
+ * 1 << PDM_DEC2_LOG2 words to pcm and returns the samples written
+ */
+uint32_t pdm_decimate(pdm_dec_t *d, const uint32_t *bits, uint32_t words, int16_t *pcm)
+{
+    uint32_t w, c, m, y, out, n = 0;
+    int32_t v;
+
+    for (uint32_t i = 0; i < words; i++) {
+        w = bits[i];
+
+        // ones count c and moment m of each bit pair, then of each
+        // nibble, byte, half and the word:  the moment of a field is the
+        // moments of its halves plus the upper half's count times the
+        // half width
+        c = w - ((w >> 1) & 0x55555555);
+        m = (w >> 1) & 0x55555555;
+        m = (m & 0x33333333) + ((m >> 2) & 0x33333333) + (((c >> 2) & 0x33333333) << 1);
+        c = (c & 0x33333333) + ((c >> 2) & 0x33333333);
+        m = (m & 0x0f0f0f0f) + ((m >> 4) & 0x0f0f0f0f) + (((c >> 4) & 0x0f0f0f0f) << 2);
+        c = (c & 0x0f0f0f0f) + ((c >> 4) & 0x0f0f0f0f);
+        m = (m & 0x00ff00ff) + ((m >> 8) & 0x00ff00ff) + (((c >> 8) & 0x00ff00ff) << 3);
+        c = (c & 0x00ff00ff) + ((c >> 8) & 0x00ff00ff);
+        m = (m & 0xffff) + (m >> 16) + ((c >> 16) << 4);
+        c = (c & 0xffff) + (c >> 16);
+
+        // stage 1:  bit j of the previous word weighs j + 1, bit j of
+        // this word 31 - j (weights sum to 1024)
+        y = d->m + d->p + (c << 5) - c - m;
+        d->p = c;
+        d->m = m;
+
+        // stage 2
+        d->i1 += y;
+        d->i2 += d->i1;
+        if (++d->phase < (1 << PDM_DEC2_LOG2))
+            continue;
+        d->phase = 0;
+        c = d->i2 - d->c1;
+        d->c1 = d->i2;
+        out = c - d->c2;
+        d->c2 = c;
+
+        v = (int32_t) (out - PDM_PCM_MID) << PDM_PCM_SHIFT;
+        pcm[n++] = v > 32767 ? 32767 : v;
+    }
+    return n;
+}
+
+/*
+ * pdm_capture()
+ * ----------------------------------------------------------------------------
+ * sample IO[36] at words * 32 rising edges of the PDM clock on IO[35];
+ * returns the words filled, fewer if the clock stopped for timeout polls
+ * (0 = wait forever).  Runs from RAM to keep up with the clock.
+ */
+RAMFUNC uint32_t pdm_capture(uint32_t *bits, uint32_t words, uint32_t timeout)
+{
+    uint32_t w, pads, t;
+
+    for (uint32_t i = 0; i < words; i++) {
+        w = 0;
+        for (uint32_t b = 0; b < 32; b++) {
+            for (t = timeout; reg_mprj_datah & PDM_CLK; )
+                if (timeout && !--t)
+                    return i;
+            for (t = timeout; !((pads = reg_mprj_datah) & PDM_CLK); )
+                if (timeout && !--t)
+                    return i;
+            w = (w >> 1) | (((pads >> PDM_DATA_SHIFT) & 1) << 31);
+        }
+        bits[i] = w;
+    }
+    return words;
+}
+
+/*
+ * pdm_pcm_dump()
+ * ----------------------------------------------------------------------------
+ * print PCM samples over the UART as "pcm <hex> ..." lines (16 bits two's
+ * complement, 16 to a line), for util/pdm_pcm.py
+ */
+void pdm_pcm_dump(const int16_t *pcm, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (!(i & (PDM_DUMP_LINE - 1)))
+            print(i ? "\npcm" : "pcm");
+        print_fmt(" %04x", (uint16_t) pcm[i]);
+    }
+    if (n)
+        print("\n");
+}
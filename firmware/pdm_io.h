@@ -0,0 +1,47 @@
+#ifndef PDM_IO_H
+#define PDM_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Software PDM-to-PCM path, a reference for the Wakey Wakey front end.
+// PDM bits are taken 32 to a word, oldest bit in bit 0 (the layout of
+// util/pdm_clips.py), either from flash or sampled off the pads with
+// pdm_capture().
+//
+// The decimator has two stages:
+//
+//   1  sinc^2 over 32 bits, one output per word:  a triangular window
+//      over the previous and the current word, computed from the ones
+//      count and the first moment (sum of set bit positions) of each
+//      word, both folded up bit-parallel with shifts, masks and adds
+//   2  CIC of order 2, decimation 1 << PDM_DEC2_LOG2
+//
+// for an overall decimation of PDM_DECIMATION and 16-bit signed PCM
+// (0 for a stream of half ones).  Everything is shifts and adds, so it
+// needs no multiply or divide.
+
+#define PDM_DEC2_LOG2		1	// 1-3
+#define PDM_DECIMATION		(32 << PDM_DEC2_LOG2)
+
+// stage gains 2^10 and 2^(2 * PDM_DEC2_LOG2), scaled to 16 bits
+#define PDM_PCM_MID		(1 << (9 + 2 * PDM_DEC2_LOG2))
+#define PDM_PCM_SHIFT		(6 - 2 * PDM_DEC2_LOG2)
+
+// Wakey Wakey pads:  the design drives the PDM clock on IO[35] and samples
+// the microphone on IO[36] on its rising edge (reg_mprj_datah bits)
+#define PDM_CLK_PAD		35
+#define PDM_DATA_PAD		36
+
+typedef struct {
+    uint32_t p, m;	// ones count and moment of the previous word
+    uint32_t i1, i2;	// stage 2 integrators
+    uint32_t c1, c2;	// stage 2 comb delays
+    uint32_t phase;	// words into the current stage 2 output
+} pdm_dec_t;
+
+void pdm_dec_init(pdm_dec_t *d);
+uint32_t pdm_decimate(pdm_dec_t *d, const uint32_t *bits, uint32_t words, int16_t *pcm);
+uint32_t pdm_capture(uint32_t *bits, uint32_t words, uint32_t timeout);
+void pdm_pcm_dump(const int16_t *pcm, uint32_t n);
+
+#endif // PDM_IO_H
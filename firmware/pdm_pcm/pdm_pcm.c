@@ -0,0 +1,118 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../gpio_config_io.h"
+#include "../pdm_io.h"
+
+// PDM to PCM in software, streamed over the UART for util/pdm_pcm.py.
+//
+// By default the PDM clips linked from flash (pdm_clips.s, made by
+// util/pdm_clips.py as for wakey_bench) are decimated block by block;
+// each clip is dumped between "pcm clip" and "pcm end" lines and the
+// decimator's cycles per PDM word are totalled for a sustained bit rate.
+//
+// Built with -DPDM_LIVE, the firmware samples the microphone line of a
+// Wakey Wakey board instead (clock from the design on IO[35], data on
+// IO[36]) one block at a time:  each block is contiguous, but the UART
+// dump leaves gaps between blocks, so the decimator restarts per block.
+
+extern const uint32_t pdm_clips[];
+
+#define PDM_CLIPS_MAGIC	0x314d4450
+#define PDM_CLIP_WORDS	5
+
+#define BLOCK_LOG2	5
+#define BLOCK_WORDS	(1 << BLOCK_LOG2)
+#define BLOCK_PCM	(BLOCK_WORDS >> PDM_DEC2_LOG2)
+
+#define LIVE_TIMEOUT	100000	// polls without a PDM clock edge
+#define LIVE_BLOCKS	64
+
+static const gpio_config_t pdm_pads[] = {
+    GPIO_PAD(6, 0x7ff),
+    GPIO_PAD(PDM_CLK_PAD, GPIO_MODE_USER_STD_OUT_MONITORED),
+    GPIO_PAD(PDM_DATA_PAD, GPIO_MODE_USER_STD_INPUT_NOPULL),
+};
+
+static int16_t pcm[BLOCK_PCM];
+
+#ifdef PDM_LIVE
+
+static uint32_t bits[BLOCK_WORDS];
+
+static void live(void)
+{
+    pdm_dec_t d;
+    uint32_t n;
+
+    for (uint32_t b = 0; b < LIVE_BLOCKS; b++) {
+        n = pdm_capture(bits, BLOCK_WORDS, LIVE_TIMEOUT);
+        if (n < BLOCK_WORDS) {
+            print("no PDM clock\n");
+            return;
+        }
+        pdm_dec_init(&d);
+        n = pdm_decimate(&d, bits, BLOCK_WORDS, pcm);
+        print_fmt("pcm block %u decimation %u\n", b, PDM_DECIMATION);
+        pdm_pcm_dump(pcm, n);
+        print("pcm end\n");
+    }
+}
+
+#else
+
+static void clips(void)
+{
+    const uint32_t *clip;
+    pdm_dec_t d;
+    char name[9];
+    uint32_t n, words, k, got, start, cycles = 0, total = 0;
+
+    if (pdm_clips[0] != PDM_CLIPS_MAGIC) {
+        print("no clips\n");
+        return;
+    }
+    n = pdm_clips[1];
+    clip = &pdm_clips[2];
+    for (uint32_t c = 0; c < n; c++, clip += PDM_CLIP_WORDS) {
+        const char *s = (const char *) &clip[3];
+
+        for (int i = 0; i < 8; i++)
+            name[i] = s[i];
+        name[8] = 0;
+        words = clip[0] >> 5;
+        print_fmt("pcm clip %s words %u decimation %u\n", name, words, PDM_DECIMATION);
+
+        pdm_dec_init(&d);
+        for (uint32_t w = 0; w < words; w += k) {
+            k = words - w < BLOCK_WORDS ? words - w : BLOCK_WORDS;
+            start = time_cycles();
+            got = pdm_decimate(&d, &pdm_clips[clip[2] + w], k, pcm);
+            cycles += time_elapsed(start);
+            pdm_pcm_dump(pcm, got);
+        }
+        print("pcm end\n");
+        total += words;
+    }
+
+    if (total)
+        print_fmt("%u words %u cycles/word  pdm %u bit/s\n", total, cycles / total,
+                  time_rate(total << 5, cycles));
+}
+
+#endif
+
+void main()
+{
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+    gpio_config(pdm_pads, GPIO_CONFIG_LEN(pdm_pads));
+
+    print("pdm_pcm\n");
+#ifdef PDM_LIVE
+    live();
+#else
+    clips();
+#endif
+}
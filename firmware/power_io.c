@@ -0,0 +1,157 @@
+#include "power_io.h"
+#include "irq_io.h"
+#include "time_io.h"
+#include "fmt_io.h"
+
+// waitirq returns once any IRQ is pending, masked or not.  The sleep
+// loop keeps every IRQ masked while it tests the wake flag and waits, and
+// only opens the mask between waits, so a timer IRQ that comes just
+// before the wait leaves its pending bit set instead of being served
+// unseen and sleeping on.
+
+#define power_waitirq() __asm__ volatile (".insn r 0x0B, 4, 4, x0, x0, x0")
+
+static volatile uint32_t power_woken;
+// 64-bit:  32-bit cycle counts wrap after 429 s at TIME_CLOCK_HZ, and
+// the stats may run for as long as the board does
+static uint64_t power_start;		// time_cycles64() at power_stats_reset()
+static uint64_t power_asleep;		// cycles asleep since then
+
+/*
+ * power_timer_irq()
+ * ----------------------------------------------------------------------------
+ * IRQ_COUNTER_TIMER1 handler: end the sleep
+ */
+void power_timer_irq(void)
+{
+    reg_timer1_config = 0;
+    power_woken = 1;
+}
+
+/*
+ * power_sleep_cycles()
+ * ----------------------------------------------------------------------------
+ * sleep for the given number of core cycles
+ */
+void power_sleep_cycles(uint32_t cycles)
+{
+    uint32_t mask, start;
+
+    if (cycles < POWER_MIN_SLEEP_CYCLES) {
+        delay_cycles(cycles);
+        return;
+    }
+
+    start = time_cycles();
+    mask = irq_setmask(0xffffffff);
+    power_woken = 0;
+    reg_timer1_config = 0;
+    reg_timer1_data = 0;
+    reg_timer1_value = cycles;
+    reg_timer1_config = TIMER_ENABLE | TIMER_ONESHOT | TIMER_IRQ_ENABLE;
+
+    while (!power_woken) {
+        power_waitirq();
+        // serve whatever is pending, the timer included
+        irq_setmask(mask & ~(1 << IRQ_COUNTER_TIMER1));
+        irq_setmask(0xffffffff);
+    }
+    irq_setmask(mask);
+    power_asleep += time_elapsed(start);
+}
+
+void power_sleep_us(uint32_t us)
+{
+    power_sleep_cycles(time_us_to_cycles(us));
+}
+
+/*
+ * power_sleep_ms()
+ * ----------------------------------------------------------------------------
+ * sleep for ms milliseconds, in POWER_SLEEP_CHUNK_MS pieces so that the
+ * cycle count cannot overflow
+ */
+void power_sleep_ms(uint32_t ms)
+{
+    for (; ms > POWER_SLEEP_CHUNK_MS; ms -= POWER_SLEEP_CHUNK_MS)
+        power_sleep_us(POWER_SLEEP_CHUNK_MS * 1000);
+    power_sleep_us((ms << 10) - (ms << 4) - (ms << 3));	// ms * 1000
+}
+
+/*
+ * power_halt()
+ * ----------------------------------------------------------------------------
+ * stop for good:  wait with every IRQ masked, and again if one comes
+ */
+void power_halt(void)
+{
+    irq_setmask(0xffffffff);
+    while (1)
+        power_waitirq();
+}
+
+/*
+ * power_stats_reset()
+ * ----------------------------------------------------------------------------
+ * start counting the duty cycle from now
+ */
+void power_stats_reset(void)
+{
+    power_start = time_cycles64();
+    power_asleep = 0;
+}
+
+/*
+ * power_duty()
+ * ----------------------------------------------------------------------------
+ * share of the time awake since power_stats_reset(), with 16 fraction bits
+ * (65536 = always awake)
+ */
+uint32_t power_duty(void)
+{
+    uint64_t total = time_cycles64() - power_start;
+
+    if (!total)
+        return 1 << 16;
+    return frac16(total - power_asleep, total);
+}
+
+/*
+ * power_report()
+ * ----------------------------------------------------------------------------
+ * print the time awake and asleep since power_stats_reset()
+ */
+void power_report(void)
+{
+    uint64_t total = time_cycles64() - power_start;
+    uint32_t duty = power_duty();
+
+    print_fmt("power: %llu cycles, %llu asleep, awake ", total, power_asleep);
+    print_fixed(frac16_percent(duty), 16, 1);
+    print_fmt("%%\n");
+}
+
+/*
+ * power_user_enable()
+ * ----------------------------------------------------------------------------
+ * enable the user power domains once reg_power_good shows their supplies
+ * good, waiting up to timeout_us; returns 0, or -1 (nothing enabled) if
+ * they did not come up
+ */
+int power_user_enable(uint32_t domains, uint32_t timeout_us)
+{
+    uint32_t deadline = time_deadline_us(timeout_us);
+
+    domains &= POWER_USER_ALL;
+    while ((reg_power_good & domains) != domains) {
+        if (time_expired(deadline))
+            return -1;
+    }
+    reg_mprj_pwr |= domains;
+    return 0;
+}
+
+void power_user_disable(uint32_t domains)
+{
+    reg_mprj_pwr &= ~(domains & POWER_USER_ALL);
+}
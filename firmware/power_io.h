@@ -0,0 +1,51 @@
+#ifndef POWER_IO_H
+#define POWER_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Low-power idle and user power domains.
+//
+// power_sleep_*() stop the core with the picorv32 waitirq instruction
+// until counter-timer 1 (one-shot) runs out.  The core has no clock gate:
+// waitirq holds it in one state with no fetches or bus traffic, which
+// takes the flash and bus out of the power budget.  Other interrupts
+// (e.g. the print_io UART drain) are served during the sleep, which then
+// goes on.  Counter-timer 1 is not free with time_timebase_start().
+//
+// Cycles spent asleep are counted from power_stats_reset(), for the duty
+// cycle in power_report().
+//
+//     power_stats_reset();
+//     while (1) {
+//         work();
+//         power_sleep_ms(100);
+//     }
+
+// Sleeps shorter than this are busy waits (the timer set-up costs more)
+#define POWER_MIN_SLEEP_CYCLES	200
+
+// Longest single timer sleep of power_sleep_ms(), in ms
+#define POWER_SLEEP_CHUNK_MS	100
+
+// User power domains:  one bit each, in the order of reg_power_good,
+// for reg_mprj_pwr as well
+#define POWER_USER1_VCCD	USER1_VCCD_POWER_GOOD
+#define POWER_USER2_VCCD	USER2_VCCD_POWER_GOOD
+#define POWER_USER1_VDDA	USER1_VDDA_POWER_GOOD
+#define POWER_USER2_VDDA	USER2_VDDA_POWER_GOOD
+#define POWER_USER_ALL		0x0f
+
+void power_sleep_cycles(uint32_t cycles);
+void power_sleep_us(uint32_t us);
+void power_sleep_ms(uint32_t ms);
+void power_halt(void);
+void power_timer_irq(void);
+
+void power_stats_reset(void);
+uint32_t power_duty(void);
+void power_report(void);
+
+int power_user_enable(uint32_t domains, uint32_t timeout_us);
+void power_user_disable(uint32_t domains);
+
+#endif // POWER_IO_H
@@ -1,10 +1,129 @@
 #include "print_io.h"
+#include "irq_io.h"
+#include "fmt_io.h"
+
+// Transmit buffer.  simpleuart has no FIFO status and no TX interrupt:  a
+// write to reg_uart_data stalls the bus until the previous character has
+// gone out.  With uart_tx_async(1), characters are queued here instead and
+// sent from the picorv32 timer interrupt, one per character time, so the
+// UART never stalls the caller.
+
+#define UART_TX_BUF_SIZE 64	// power of two
+
+static volatile uint8_t uart_tx_buf[UART_TX_BUF_SIZE];
+static volatile uint32_t uart_tx_head;
+static volatile uint32_t uart_tx_tail;
+static volatile uint32_t uart_tx_busy;
+static uint32_t uart_tx_ticks;
+static uint32_t uart_tx_on;
+
+static void uart_tx_send(uint32_t c)
+{
+	reg_uart_data = c;
+	uart_tx_busy = 1;
+	irq_timer(uart_tx_ticks);
+}
+
+/*
+ * uart_tx_irq()
+ * ----------------------------------------------------------------------------
+ * IRQ_TIMER handler: the last character is out, send the next one
+ */
+void uart_tx_irq()
+{
+	if (uart_tx_head != uart_tx_tail) {
+		uart_tx_send(uart_tx_buf[uart_tx_tail & (UART_TX_BUF_SIZE - 1)]);
+		uart_tx_tail++;
+	} else {
+		uart_tx_busy = 0;
+	}
+}
+
+/*
+ * uart_tx_async()
+ * ----------------------------------------------------------------------------
+ * switch putchar() between the interrupt-driven buffer (1) and writing
+ * the UART directly (0).  Call after reg_uart_clkdiv is set.
+ */
+void uart_tx_async(int enable)
+{
+	uart_flush();
+	if (enable) {
+		// 10 bits per character, plus one bit of margin
+		uint32_t div = reg_uart_clkdiv;
+		uart_tx_ticks = (div << 3) + (div << 1) + div;
+		irq_enable(IRQ_TIMER);
+	} else {
+		irq_disable(IRQ_TIMER);
+	}
+	uart_tx_on = enable;
+}
+
+/*
+ * uart_tx_pending()
+ * ----------------------------------------------------------------------------
+ * number of characters waiting in the buffer
+ */
+uint32_t uart_tx_pending()
+{
+	return uart_tx_head - uart_tx_tail;
+}
+
+/*
+ * uart_flush()
+ * ----------------------------------------------------------------------------
+ * send every buffered character and wait until the last one is out.  The
+ * ring is drained from here with IRQs masked, as putchar() does when it
+ * is full, rather than left to the timer IRQ:  that may be masked, routed
+ * to another handler (irq_attach()) or blocked because this is called
+ * from a handler.
+ */
+void uart_flush()
+{
+	uint32_t mask, start, now;
+
+	if (!uart_tx_busy)
+		return;
+
+	mask = irq_setmask(0xffffffff);
+	// each write stalls until the previous character has gone out
+	while (uart_tx_head != uart_tx_tail) {
+		reg_uart_data = uart_tx_buf[uart_tx_tail & (UART_TX_BUF_SIZE - 1)];
+		uart_tx_tail++;
+	}
+	irq_timer(0);
+	__asm__ volatile ("rdcycle %0" : "=r"(start));
+	do
+		__asm__ volatile ("rdcycle %0" : "=r"(now));
+	while (now - start < uart_tx_ticks);
+	uart_tx_busy = 0;
+	irq_setmask(mask);
+}
 
 void putchar(uint32_t c)
 {
 	if (c == '\n')
 		putchar('\r');
-	reg_uart_data = c;
+
+	if (!uart_tx_on) {
+		reg_uart_data = c;
+		return;
+	}
+
+	uint32_t mask = irq_setmask(0xffffffff);
+	if (!uart_tx_busy) {
+		uart_tx_send(c);
+	} else {
+		if (uart_tx_head - uart_tx_tail == UART_TX_BUF_SIZE) {
+			// Buffer full: send the oldest character from here, which
+			// blocks for one character time like the direct path
+			uart_tx_send(uart_tx_buf[uart_tx_tail & (UART_TX_BUF_SIZE - 1)]);
+			uart_tx_tail++;
+		}
+		uart_tx_buf[uart_tx_head & (UART_TX_BUF_SIZE - 1)] = c;
+		uart_tx_head++;
+	}
+	irq_setmask(mask);
 //	reg_uart1_data = c;
 }
 
@@ -24,68 +143,16 @@ void print_hex(uint32_t v, int digits)
 
 void print_dec(uint32_t v)
 {
-	if (v >= 2000) {
-		print("OVER");
-		return;
-	}
-	else if (v >= 1000) { putchar('1'); v -= 1000; }
-	else putchar(' ');
-
-	if 	(v >= 900) { putchar('9'); v -= 900; }
-	else if	(v >= 800) { putchar('8'); v -= 800; }
-	else if	(v >= 700) { putchar('7'); v -= 700; }
-	else if	(v >= 600) { putchar('6'); v -= 600; }
-	else if	(v >= 500) { putchar('5'); v -= 500; }
-	else if	(v >= 400) { putchar('4'); v -= 400; }
-	else if	(v >= 300) { putchar('3'); v -= 300; }
-	else if	(v >= 200) { putchar('2'); v -= 200; }
-	else if	(v >= 100) { putchar('1'); v -= 100; }
-	else putchar('0');
-
-	if 	(v >= 90) { putchar('9'); v -= 90; }
-	else if	(v >= 80) { putchar('8'); v -= 80; }
-	else if	(v >= 70) { putchar('7'); v -= 70; }
-	else if	(v >= 60) { putchar('6'); v -= 60; }
-	else if	(v >= 50) { putchar('5'); v -= 50; }
-	else if	(v >= 40) { putchar('4'); v -= 40; }
-	else if	(v >= 30) { putchar('3'); v -= 30; }
-	else if	(v >= 20) { putchar('2'); v -= 20; }
-	else if	(v >= 10) { putchar('1'); v -= 10; }
-	else putchar('0');
-
-	if 	(v >= 9) { putchar('9'); v -= 9; }
-	else if	(v >= 8) { putchar('8'); v -= 8; }
-	else if	(v >= 7) { putchar('7'); v -= 7; }
-	else if	(v >= 6) { putchar('6'); v -= 6; }
-	else if	(v >= 5) { putchar('5'); v -= 5; }
-	else if	(v >= 4) { putchar('4'); v -= 4; }
-	else if	(v >= 3) { putchar('3'); v -= 3; }
-	else if	(v >= 2) { putchar('2'); v -= 2; }
-	else if	(v >= 1) { putchar('1'); v -= 1; }
-	else putchar('0');
+	char buf[FMT_U32_LEN];
+	int len = fmt_u32(buf, v);
+
+	for (int i = 0; i < len; i++)
+		putchar(buf[i]);
 }
 
 void print_digit(uint32_t v)
 {
-    v &= (uint32_t)0x000F;
-
-    if (v == 9) { putchar('9'); }
-    else if (v == 8) { putchar('8'); }
-    else if (v == 7) { putchar('7'); }
-    else if (v == 6) { putchar('6'); }
-    else if (v == 5) { putchar('5'); }
-    else if (v == 4) { putchar('4'); }
-    else if (v == 3) { putchar('3'); }
-    else if (v == 2) { putchar('2'); }
-    else if (v == 1) { putchar('1'); }
-    else if (v == 0) { putchar('0'); }
-    else if (v == 10) { putchar('a'); }
-    else if (v == 11) { putchar('b'); }
-    else if (v == 12) { putchar('c'); }
-    else if (v == 13) { putchar('d'); }
-    else if (v == 14) { putchar('e'); }
-    else if (v == 15) { putchar('f'); }
-    else putchar('*');
+	putchar("0123456789abcdef"[v & 15]);
 }
 
 //char getchar_prompt(char *prompt)
@@ -7,6 +7,10 @@
 #include "defs_mpw-two-mfix.h"
 
 void putchar(uint32_t c);
+void uart_tx_async(int enable);
+void uart_tx_irq();
+void uart_flush();
+uint32_t uart_tx_pending();
 void print(const char *p);
 void print_hex(uint32_t v, int digits);
 void print_dec(uint32_t v);
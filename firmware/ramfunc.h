@@ -0,0 +1,15 @@
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+// Functions marked RAMFUNC are linked into the .ramfunc section, which
+// sections.lds places at the start of .data:  start.s copies them from
+// flash into RAM with the initialized data, and they execute without
+// flash fetch stalls.  RAM is 1 KB shared with .data, .bss and the
+// stack, so keep this for small inner loops (check "make report").
+//
+// Constants and string literals used by a RAMFUNC stay in flash, and any
+// function it calls runs from flash unless that one is a RAMFUNC too.
+
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+#endif // RAMFUNC_H
@@ -0,0 +1,104 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../ramfunc.h"
+
+// Runs the same inner loops from flash (XIP) and from RAM (RAMFUNC) and
+// prints the cycles per iteration of each.  Every loop is defined twice
+// from one macro so both copies compile to the same instructions.
+
+#define ITER_SHIFT	8
+#define ITER		(1 << ITER_SHIFT)
+#define WORDS		32
+
+static uint32_t buf[WORDS];
+
+// Empty counted loop
+#define LOOP_COUNT(name, attr)						\
+attr void name(uint32_t n)						\
+{									\
+    for (volatile uint32_t i = 0; i < n; i++);				\
+}
+
+// Toggle a user area pad from the management core
+#define LOOP_TOGGLE(name, attr)						\
+attr void name(uint32_t n)						\
+{									\
+    uint32_t v = reg_mprj_datal;					\
+    for (uint32_t i = 0; i < n; i++) {					\
+        v ^= 1 << 8;							\
+        reg_mprj_datal = v;						\
+    }									\
+}
+
+// Memory test inner loop:  write an address pattern, read it back
+#define LOOP_MEMTEST(name, attr)					\
+attr uint32_t name(uint32_t *p, uint32_t n)				\
+{									\
+    uint32_t errors = 0;						\
+    for (uint32_t i = 0; i < n; i++)					\
+        p[i] = (uint32_t) &p[i] ^ 0xa5a5a5a5;				\
+    for (uint32_t i = 0; i < n; i++)					\
+        if (p[i] != ((uint32_t) &p[i] ^ 0xa5a5a5a5))			\
+            errors++;							\
+    return errors;							\
+}
+
+LOOP_COUNT(count_flash, )
+LOOP_COUNT(count_ram, RAMFUNC)
+LOOP_TOGGLE(toggle_flash, )
+LOOP_TOGGLE(toggle_ram, RAMFUNC)
+LOOP_MEMTEST(memtest_flash, )
+LOOP_MEMTEST(memtest_ram, RAMFUNC)
+
+// Cycles per iteration as fixed point with ITER_SHIFT fraction bits
+static void report(const char *name, uint32_t flash, uint32_t ram)
+{
+    print_fmt("%-8s flash ", name);
+    print_fixed(flash, ITER_SHIFT, 2);
+    print("  ram ");
+    print_fixed(ram, ITER_SHIFT, 2);
+    print("  cycles/iteration\n");
+}
+
+void main()
+{
+    uint32_t start, flash, ram;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    reg_mprj_io_8 = GPIO_MODE_MGMT_STD_OUTPUT;
+    reg_mprj_xfer = 1;
+    while (reg_mprj_xfer == 1);
+
+    print("ramfunc_bench\n");
+
+    start = time_cycles();
+    count_flash(ITER);
+    flash = time_elapsed(start);
+    start = time_cycles();
+    count_ram(ITER);
+    ram = time_elapsed(start);
+    report("count", flash, ram);
+
+    start = time_cycles();
+    toggle_flash(ITER);
+    flash = time_elapsed(start);
+    start = time_cycles();
+    toggle_ram(ITER);
+    ram = time_elapsed(start);
+    report("toggle", flash, ram);
+
+    // WORDS * 8 = ITER word accesses per pass
+    start = time_cycles();
+    for (int i = 0; i < 8; i++)
+        memtest_flash(buf, WORDS);
+    flash = time_elapsed(start);
+    start = time_cycles();
+    for (int i = 0; i < 8; i++)
+        memtest_ram(buf, WORDS);
+    ram = time_elapsed(start);
+    report("memtest", flash, ram);
+}
@@ -0,0 +1,21 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stddef.h>
+#include "defs_mpw-two-mfix.h"
+
+// Freestanding runtime (runtime.s), linked into every firmware after
+// start.s.  It provides the memory routines gcc may call on its own for
+// struct copies and initializers, and the helpers it calls for 32-bit
+// multiply, divide and remainder under -march=rv32i, so "*", "/" and "%"
+// build without libgcc.  Each one is a call and a loop:  a multiply costs
+// a few cycles per pair of bits in the smaller operand, a divide a few
+// per quotient bit.  Divides by constants in hot paths are still better
+// written as shifts and adds (divu10() in fmt_io.c, the conversions in
+// time_io.c).  64-bit multiply and divide are not provided.
+
+void *memcpy(void *dst, const void *src, size_t n);
+void *memset(void *dst, int c, size_t n);
+int memcmp(const void *a, const void *b, size_t n);
+
+#endif // RUNTIME_H
@@ -0,0 +1,278 @@
+# Freestanding runtime for -ffreestanding -nostdlib builds (see runtime.h):
+# memcpy, memset and memcmp, which gcc may call for struct copies and
+# initializers, and the rv32i multiply and divide helpers it calls for
+# "*", "/" and "%".  Written in assembly so that they are the same fast
+# code in every build profile; none of them uses the stack.
+#
+# Linked before -lgcc, these take the place of the libgcc versions.
+
+.section .text
+
+# ---- Memory ----
+
+# void *memcpy(void *dst, const void *src, size_t n)
+#
+# When dst and src share their alignment:  bytes up to a word boundary,
+# then 16 bytes per iteration, then words, then the last bytes.  Otherwise
+# byte by byte (picorv32 traps misaligned word accesses).
+.global memcpy
+.balign 4
+memcpy:
+	mv	t6, a0
+	xor	t0, a0, a1
+	andi	t0, t0, 3
+	bnez	t0, memcpy_bytes
+memcpy_head:
+	andi	t0, t6, 3
+	beqz	t0, memcpy_aligned
+	beqz	a2, memcpy_done
+	lbu	t0, 0(a1)
+	sb	t0, 0(t6)
+	addi	a1, a1, 1
+	addi	t6, t6, 1
+	addi	a2, a2, -1
+	j	memcpy_head
+memcpy_aligned:
+	li	t5, 15
+	bgeu	t5, a2, memcpy_words
+memcpy_block:
+	lw	t0, 0(a1)
+	lw	t1, 4(a1)
+	lw	t2, 8(a1)
+	lw	t3, 12(a1)
+	sw	t0, 0(t6)
+	sw	t1, 4(t6)
+	sw	t2, 8(t6)
+	sw	t3, 12(t6)
+	addi	a1, a1, 16
+	addi	t6, t6, 16
+	addi	a2, a2, -16
+	bltu	t5, a2, memcpy_block
+memcpy_words:
+	li	t5, 3
+	bgeu	t5, a2, memcpy_bytes
+memcpy_word:
+	lw	t0, 0(a1)
+	sw	t0, 0(t6)
+	addi	a1, a1, 4
+	addi	t6, t6, 4
+	addi	a2, a2, -4
+	bltu	t5, a2, memcpy_word
+memcpy_bytes:
+	beqz	a2, memcpy_done
+memcpy_byte:
+	lbu	t0, 0(a1)
+	sb	t0, 0(t6)
+	addi	a1, a1, 1
+	addi	t6, t6, 1
+	addi	a2, a2, -1
+	bnez	a2, memcpy_byte
+memcpy_done:
+	ret
+
+# void *memset(void *dst, int c, size_t n)
+#
+# Bytes up to a word boundary, then the byte repeated in a word 16 bytes
+# per iteration, then words, then the last bytes.
+.global memset
+.balign 4
+memset:
+	mv	t6, a0
+	andi	a1, a1, 0xff
+	slli	t0, a1, 8
+	or	a1, a1, t0
+	slli	t0, a1, 16
+	or	a1, a1, t0
+memset_head:
+	andi	t0, t6, 3
+	beqz	t0, memset_aligned
+	beqz	a2, memset_done
+	sb	a1, 0(t6)
+	addi	t6, t6, 1
+	addi	a2, a2, -1
+	j	memset_head
+memset_aligned:
+	li	t5, 15
+	bgeu	t5, a2, memset_words
+memset_block:
+	sw	a1, 0(t6)
+	sw	a1, 4(t6)
+	sw	a1, 8(t6)
+	sw	a1, 12(t6)
+	addi	t6, t6, 16
+	addi	a2, a2, -16
+	bltu	t5, a2, memset_block
+memset_words:
+	li	t5, 3
+	bgeu	t5, a2, memset_bytes
+memset_word:
+	sw	a1, 0(t6)
+	addi	t6, t6, 4
+	addi	a2, a2, -4
+	bltu	t5, a2, memset_word
+memset_bytes:
+	beqz	a2, memset_done
+memset_byte:
+	sb	a1, 0(t6)
+	addi	t6, t6, 1
+	addi	a2, a2, -1
+	bnez	a2, memset_byte
+memset_done:
+	ret
+
+# int memcmp(const void *a, const void *b, size_t n)
+#
+# Word compares while both are word aligned;  the first differing word,
+# and the tail, are compared byte by byte for the sign of the result.
+.global memcmp
+.balign 4
+memcmp:
+	or	t0, a0, a1
+	andi	t0, t0, 3
+	bnez	t0, memcmp_bytes
+	li	t5, 3
+memcmp_word:
+	bgeu	t5, a2, memcmp_bytes
+	lw	t0, 0(a0)
+	lw	t1, 0(a1)
+	bne	t0, t1, memcmp_bytes
+	addi	a0, a0, 4
+	addi	a1, a1, 4
+	addi	a2, a2, -4
+	j	memcmp_word
+memcmp_bytes:
+	beqz	a2, memcmp_equal
+memcmp_byte:
+	lbu	t0, 0(a0)
+	lbu	t1, 0(a1)
+	bne	t0, t1, memcmp_differ
+	addi	a0, a0, 1
+	addi	a1, a1, 1
+	addi	a2, a2, -1
+	bnez	a2, memcmp_byte
+memcmp_equal:
+	li	a0, 0
+	ret
+memcmp_differ:
+	sub	a0, t0, t1
+	ret
+
+# ---- Multiply and divide ----
+
+# uint32_t __mulsi3(uint32_t a, uint32_t b)
+#
+# Shift and add over the bits of the smaller operand, two per iteration,
+# stopping when none are left:  a multiply by a small constant or a
+# small count takes a few iterations instead of 32.
+.global __mulsi3
+.balign 4
+__mulsi3:
+	bgeu	a1, a0, mulsi3_start
+	mv	t0, a0
+	mv	a0, a1
+	mv	a1, t0
+mulsi3_start:
+	# a0 = multiplier (smaller), a1 = multiplicand
+	mv	t1, a0
+	li	a0, 0
+	beqz	t1, mulsi3_done
+mulsi3_loop:
+	andi	t0, t1, 1
+	beqz	t0, mulsi3_bit1
+	add	a0, a0, a1
+mulsi3_bit1:
+	andi	t0, t1, 2
+	beqz	t0, mulsi3_next
+	slli	t0, a1, 1
+	add	a0, a0, t0
+mulsi3_next:
+	srli	t1, t1, 2
+	slli	a1, a1, 2
+	bnez	t1, mulsi3_loop
+mulsi3_done:
+	ret
+
+# uint32_t __udivsi3(uint32_t n, uint32_t d)
+#
+# Shift and subtract, starting from the divisor shifted up to the
+# dividend, so the loop runs once per quotient bit that can be set
+# (none when d > n).  Returns the quotient in a0 and leaves the remainder
+# in a1 for __umodsi3 and the signed versions, which keep state in t4-t6.
+# As the RISC-V divide instructions:  n / 0 = 0xffffffff, n % 0 = n.
+.global __udivsi3
+.balign 4
+__udivsi3:
+	mv	a2, a1
+	mv	a1, a0
+	li	a0, -1
+	beqz	a2, udivsi3_done
+	li	a3, 1
+	bgeu	a2, a1, udivsi3_div
+udivsi3_align:
+	bltz	a2, udivsi3_div
+	slli	a2, a2, 1
+	slli	a3, a3, 1
+	bgtu	a1, a2, udivsi3_align
+udivsi3_div:
+	li	a0, 0
+udivsi3_loop:
+	bltu	a1, a2, udivsi3_next
+	sub	a1, a1, a2
+	or	a0, a0, a3
+udivsi3_next:
+	srli	a3, a3, 1
+	srli	a2, a2, 1
+	bnez	a3, udivsi3_loop
+udivsi3_done:
+	ret
+
+# uint32_t __umodsi3(uint32_t n, uint32_t d)
+.global __umodsi3
+.balign 4
+__umodsi3:
+	mv	t6, ra
+	jal	__udivsi3
+	mv	a0, a1
+	jr	t6
+
+# int32_t __divsi3(int32_t n, int32_t d)
+#
+# Unsigned divide of the magnitudes;  the quotient is negative when the
+# signs differ.  n / 0 is -1 whatever the sign of n, as for div.
+.global __divsi3
+.balign 4
+__divsi3:
+	beqz	a1, divsi3_zero
+	mv	t6, ra
+	srai	t5, a0, 31
+	srai	t4, a1, 31
+	xor	a0, a0, t5
+	sub	a0, a0, t5
+	xor	a1, a1, t4
+	sub	a1, a1, t4
+	jal	__udivsi3
+	xor	t5, t5, t4
+	xor	a0, a0, t5
+	sub	a0, a0, t5
+	jr	t6
+divsi3_zero:
+	li	a0, -1
+	ret
+
+# int32_t __modsi3(int32_t n, int32_t d)
+#
+# The remainder takes the sign of the dividend.
+.global __modsi3
+.balign 4
+__modsi3:
+	mv	t6, ra
+	srai	t5, a0, 31
+	srai	t4, a1, 31
+	xor	a0, a0, t5
+	sub	a0, a0, t5
+	xor	a1, a1, t4
+	sub	a1, a1, t4
+	jal	__udivsi3
+	xor	a0, a1, t5
+	sub	a0, a0, t5
+	jr	t6
@@ -0,0 +1,177 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../runtime.h"
+
+// Cycles of the runtime.s routines against the plain C loops they replace,
+// with the results of both compared:  memcpy, memset and memcmp on aligned
+// and misaligned buffers of a few sizes, and multiply, divide and remainder
+// (which gcc turns into __mulsi3, __udivsi3 and __umodsi3 calls under
+// -march=rv32i) on small and large operands.
+
+#define BUF_WORDS	32
+#define BUF_BYTES	(BUF_WORDS << 2)
+
+static uint32_t src_buf[BUF_WORDS];
+static uint32_t dst_buf[BUF_WORDS];
+static uint32_t errors;
+
+static void naive_memcpy(uint8_t *d, const uint8_t *s, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+        d[i] = s[i];
+}
+
+static void naive_memset(uint8_t *d, uint8_t c, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+        d[i] = c;
+}
+
+static int naive_memcmp(const uint8_t *a, const uint8_t *b, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+        if (a[i] != b[i])
+            return a[i] - b[i];
+    return 0;
+}
+
+// shift and add over all 32 bits
+static uint32_t naive_mul(uint32_t a, uint32_t b)
+{
+    uint32_t p = 0;
+
+    for (int i = 0; i < 32; i++) {
+        if (b & 1)
+            p += a;
+        a <<= 1;
+        b >>= 1;
+    }
+    return p;
+}
+
+// restoring division over all 32 bits
+static uint32_t naive_divmod(uint32_t n, uint32_t d, uint32_t *rem)
+{
+    uint32_t q = 0, r = 0;
+
+    for (int i = 31; i >= 0; i--) {
+        r = (r << 1) | ((n >> i) & 1);
+        q <<= 1;
+        if (r >= d) {
+            r -= d;
+            q |= 1;
+        }
+    }
+    *rem = r;
+    return q;
+}
+
+static void report(const char *what, uint32_t arg, uint32_t naive, uint32_t fast)
+{
+    print_fmt("%-8s %10u  naive %5u  runtime %5u cycles\n", what, arg, naive, fast);
+}
+
+static void fill(uint32_t seed)
+{
+    for (int i = 0; i < BUF_WORDS; i++) {
+        seed = (seed << 1) ^ (seed & 0x80000000 ? 0x04c11db7 : 0);
+        src_buf[i] = seed;
+    }
+}
+
+static void bench_mem(uint32_t n, uint32_t offset)
+{
+    uint8_t *s = (uint8_t *) src_buf + offset;
+    uint8_t *d = (uint8_t *) dst_buf;
+    uint32_t start, naive, fast;
+    int x, y;
+
+    start = time_cycles();
+    naive_memcpy(d, s, n);
+    naive = time_elapsed(start);
+    naive_memset(d, 0, n);
+    start = time_cycles();
+    memcpy(d, s, n);
+    fast = time_elapsed(start);
+    if (naive_memcmp(d, s, n) != 0)
+        errors++;
+    report(offset ? "memcpy+1" : "memcpy", n, naive, fast);
+
+    start = time_cycles();
+    naive_memset(d, 0x5a, n);
+    naive = time_elapsed(start);
+    start = time_cycles();
+    memset(d, 0xa5, n);
+    fast = time_elapsed(start);
+    for (uint32_t i = 0; i < n; i++)
+        if (d[i] != 0xa5)
+            errors++;
+    report("memset", n, naive, fast);
+
+    // equal buffers, so both compare all n bytes
+    memcpy(d, s, n);
+    start = time_cycles();
+    x = naive_memcmp(d, s, n);
+    naive = time_elapsed(start);
+    start = time_cycles();
+    y = memcmp(d, s, n);
+    fast = time_elapsed(start);
+    if (x || y)
+        errors++;
+    report(offset ? "memcmp+1" : "memcmp", n, naive, fast);
+}
+
+static void bench_arith(uint32_t a, uint32_t b)
+{
+    uint32_t start, naive, fast, x, y, r;
+
+    start = time_cycles();
+    x = naive_mul(a, b);
+    naive = time_elapsed(start);
+    start = time_cycles();
+    y = a * b;
+    fast = time_elapsed(start);
+    if (x != y)
+        errors++;
+    report("mul", b, naive, fast);
+
+    start = time_cycles();
+    x = naive_divmod(a, b, &r);
+    naive = time_elapsed(start);
+    start = time_cycles();
+    y = a / b;
+    fast = time_elapsed(start);
+    if (x != y)
+        errors++;
+    report("div", b, naive, fast);
+
+    start = time_cycles();
+    y = a % b;
+    fast = time_elapsed(start);
+    if (r != y)
+        errors++;
+    report("mod", b, naive, fast);
+}
+
+void main()
+{
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    print("runtime_bench\n");
+
+    fill(0x1234567);
+    bench_mem(8, 0);
+    bench_mem(BUF_BYTES >> 2, 0);
+    bench_mem(BUF_BYTES - 4, 0);
+    bench_mem(BUF_BYTES - 4, 1);
+
+    bench_arith(123456789, 10);
+    bench_arith(123456789, 1000);
+    bench_arith(0xfedcba98, 0x12345);
+    bench_arith(0xfedcba98, 0x7fffffff);
+
+    print_fmt("%u errors\n", errors);
+}
@@ -0,0 +1,79 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../irq_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../spimaster_io.h"
+#include "../hello/spi_io.h"
+
+// Transfers the same buffer through the bit-banged driver (hello/spi_io.c)
+// and through the SPI master (polled per byte, stream mode and interrupt
+// driven) and prints the time each one takes.  With SDO looped back to
+// SDI (or "make sim", which models a loopback) the received data is
+// checked too.
+
+#define LEN 64
+
+static uint8_t tx[LEN];
+static uint8_t rx[LEN];
+
+static void report(const char *name, uint32_t cycles, int check)
+{
+    uint32_t us = time_cycles_to_us(cycles);
+    int errors = 0;
+
+    if (check)
+        for (int i = 0; i < LEN; i++)
+            if (rx[i] != tx[i])
+                errors++;
+
+    print_fmt("%-10s %8u cycles %8u us", name, cycles, us);
+    if (check)
+        print_fmt(" %u errors", errors);
+    print("\n");
+}
+
+void main()
+{
+    uint32_t start;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    for (int i = 0; i < LEN; i++)
+        tx[i] = 0xa5 ^ i;
+
+    print_fmt("spi_bench %u bytes\n", LEN);
+
+    // Bit-banged baseline
+    spi_init();
+    start = time_cycles();
+    spi_start();
+    for (int i = 0; i < LEN; i++)
+        spi_write(tx[i]);
+    spi_stop();
+    report("bitbang", time_elapsed(start), 0);
+
+    // SPI master at core clock / 4
+    spimaster_pads();
+    spimaster_init(2, 0);
+
+    start = time_cycles();
+    spimaster_transfer(tx, rx, LEN);
+    report("polled", time_elapsed(start), 1);
+
+    start = time_cycles();
+    spimaster_begin();
+    spimaster_write(tx, LEN);
+    spimaster_end();
+    report("stream", time_elapsed(start), 0);
+
+    irq_enable(IRQ_SPI_MASTER);
+    for (int i = 0; i < LEN; i++)
+        rx[i] = 0;
+    start = time_cycles();
+    spimaster_start(tx, rx, LEN);
+    while (spimaster_busy());
+    report("irq", time_elapsed(start), 1);
+    irq_disable(IRQ_SPI_MASTER);
+}
@@ -0,0 +1,140 @@
+#include "spimaster_io.h"
+
+// Writing reg_spimaster_data starts an 8-bit transfer; reading it returns
+// the byte received by the last transfer and stalls the bus until that
+// transfer has finished.  Without SPI_MASTER_STREAM, CSB is raised after
+// every byte; with it, CSB stays low until the bit is cleared again.
+
+static uint32_t spimaster_config;
+
+// Interrupt-driven transfer state (see spimaster_start())
+static const uint8_t *volatile spimaster_tx;
+static uint8_t *volatile spimaster_rx;
+static volatile int spimaster_left;
+
+/*
+ * spimaster_pads()
+ * ----------------------------------------------------------------------------
+ * hand the SPI master pins to the management core and transfer the
+ * pad configuration
+ */
+void spimaster_pads()
+{
+    reg_mprj_io_32 = GPIO_MODE_MGMT_STD_OUTPUT;
+    reg_mprj_io_33 = GPIO_MODE_MGMT_STD_OUTPUT;
+    reg_mprj_io_34 = GPIO_MODE_MGMT_STD_INPUT_NOPULL;
+    reg_mprj_io_35 = GPIO_MODE_MGMT_STD_OUTPUT;
+
+    reg_mprj_xfer = 1;
+    while (reg_mprj_xfer == 1);
+}
+
+/*
+ * spimaster_init()
+ * ----------------------------------------------------------------------------
+ * enable the SPI master with clock divider div (1 to 255) and mode flags
+ * (SPI_MASTER_MLB, SPI_MASTER_INV_CSB, SPI_MASTER_INV_CLK, SPI_MASTER_MODE_1)
+ */
+void spimaster_init(uint32_t div, uint32_t flags)
+{
+    spimaster_config = SPI_MASTER_ENABLE | (flags & ~SPI_MASTER_DIV_MASK)
+                     | (div & SPI_MASTER_DIV_MASK);
+    spimaster_config &= ~(SPI_MASTER_STREAM | SPI_MASTER_IRQ_ENABLE);
+    reg_spimaster_config = spimaster_config;
+}
+
+/*
+ * spimaster_xfer()
+ * ----------------------------------------------------------------------------
+ * send one byte and return the byte received
+ */
+uint32_t spimaster_xfer(uint32_t data)
+{
+    reg_spimaster_data = data;
+    return reg_spimaster_data;
+}
+
+/*
+ * spimaster_begin()
+ * ----------------------------------------------------------------------------
+ * hold CSB low across the following transfers (stream mode)
+ */
+void spimaster_begin()
+{
+    reg_spimaster_config = spimaster_config | SPI_MASTER_STREAM;
+}
+
+/*
+ * spimaster_end()
+ * ----------------------------------------------------------------------------
+ * release CSB after the last transfer
+ */
+void spimaster_end()
+{
+    (void) reg_spimaster_data;	// wait for the last byte
+    reg_spimaster_config = spimaster_config;
+}
+
+void spimaster_write(const uint8_t *buf, int len)
+{
+    // The next write only has to wait for the bus, not for a read-back
+    for (int i = 0; i < len; i++)
+        reg_spimaster_data = buf[i];
+}
+
+void spimaster_read(uint8_t *buf, int len, uint32_t fill)
+{
+    for (int i = 0; i < len; i++) {
+        reg_spimaster_data = fill;
+        buf[i] = reg_spimaster_data;
+    }
+}
+
+void spimaster_transfer(const uint8_t *tx, uint8_t *rx, int len)
+{
+    for (int i = 0; i < len; i++) {
+        reg_spimaster_data = tx[i];
+        rx[i] = reg_spimaster_data;
+    }
+}
+
+/*
+ * spimaster_start()
+ * ----------------------------------------------------------------------------
+ * start an interrupt-driven stream transfer of len bytes (rx may be 0) and
+ * return at once; IRQ_SPI_MASTER must be enabled.  spimaster_busy() is
+ * true until the last byte is in and CSB is released.
+ */
+void spimaster_start(const uint8_t *tx, uint8_t *rx, int len)
+{
+    if (len <= 0)
+        return;
+    spimaster_tx = tx;
+    spimaster_rx = rx;
+    spimaster_left = len;
+    reg_spimaster_config = spimaster_config | SPI_MASTER_STREAM | SPI_MASTER_IRQ_ENABLE;
+    reg_spimaster_data = *spimaster_tx++;
+}
+
+int spimaster_busy()
+{
+    return spimaster_left != 0;
+}
+
+/*
+ * spimaster_irq()
+ * ----------------------------------------------------------------------------
+ * IRQ_SPI_MASTER handler: store the byte received, send the next one
+ */
+void spimaster_irq()
+{
+    if (!spimaster_left)
+        return;
+    uint32_t data = reg_spimaster_data;
+    if (spimaster_rx)
+        *spimaster_rx++ = data;
+    if (--spimaster_left)
+        reg_spimaster_data = *spimaster_tx++;
+    else
+        reg_spimaster_config = spimaster_config;
+}
@@ -0,0 +1,27 @@
+#ifndef SPIMASTER_IO_H
+#define SPIMASTER_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Driver for the management SoC SPI master (reg_spimaster_config/data).
+// SCK = core clock / (2 * div).  The pads are on the user area GPIO
+// (Caravel pinout):
+#define SPIMASTER_SCK_PIN	32
+#define SPIMASTER_CSB_PIN	33
+#define SPIMASTER_SDI_PIN	34
+#define SPIMASTER_SDO_PIN	35
+
+void spimaster_pads();
+void spimaster_init(uint32_t div, uint32_t flags);
+uint32_t spimaster_xfer(uint32_t data);
+void spimaster_begin();
+void spimaster_end();
+void spimaster_write(const uint8_t *buf, int len);
+void spimaster_read(uint8_t *buf, int len, uint32_t fill);
+void spimaster_transfer(const uint8_t *tx, uint8_t *rx, int len);
+
+void spimaster_start(const uint8_t *tx, uint8_t *rx, int len);
+int spimaster_busy();
+void spimaster_irq();
+
+#endif // SPIMASTER_IO_H
@@ -1,6 +1,89 @@
 .section .text
 
+.global start
+.global irq_vector
+.weak irq_table
+
 start:
+j reset_vector
+
+# picorv32 jumps here on an interrupt (PROGADDR_IRQ = reset + 0x10), with
+# the return address in x3 (gp) and the pending IRQ bits in x4 (tp).
+# Main code must leave gp and tp alone.  The caller-saved registers, and
+# s0/s1 which the dispatch loop keeps across calls, are saved on the
+# current stack.  Then the handler in irq_table[] (irq_io.c) of every
+# pending IRQ is called, lowest IRQ first, skipping four idle lines at a
+# time.  Without irq_io.c linked in, the IRQs are just returned from.
+.balign 16
+irq_vector:
+addi sp, sp, -80
+sw ra, 0(sp)
+sw t0, 4(sp)
+sw t1, 8(sp)
+sw t2, 12(sp)
+sw a0, 16(sp)
+sw a1, 20(sp)
+sw a2, 24(sp)
+sw a3, 28(sp)
+sw a4, 32(sp)
+sw a5, 36(sp)
+sw a6, 40(sp)
+sw a7, 44(sp)
+sw t3, 48(sp)
+sw t4, 52(sp)
+sw t5, 56(sp)
+sw t6, 60(sp)
+sw s0, 64(sp)
+sw s1, 68(sp)
+
+la s1, irq_table
+beqz s1, irq_vector_done
+# s0 = pending IRQs with a handler slot (IRQ_LINES = 16)
+slli s0, tp, 16
+srli s0, s0, 16
+irq_vector_next:
+beqz s0, irq_vector_done
+andi t0, s0, 15
+bnez t0, irq_vector_bit
+srli s0, s0, 4
+addi s1, s1, 16
+j irq_vector_next
+irq_vector_bit:
+andi t0, s0, 1
+beqz t0, irq_vector_skip
+lw t0, 0(s1)
+beqz t0, irq_vector_skip
+jalr t0
+irq_vector_skip:
+srli s0, s0, 1
+addi s1, s1, 4
+j irq_vector_next
+irq_vector_done:
+
+lw ra, 0(sp)
+lw t0, 4(sp)
+lw t1, 8(sp)
+lw t2, 12(sp)
+lw a0, 16(sp)
+lw a1, 20(sp)
+lw a2, 24(sp)
+lw a3, 28(sp)
+lw a4, 32(sp)
+lw a5, 36(sp)
+lw a6, 40(sp)
+lw a7, 44(sp)
+lw t3, 48(sp)
+lw t4, 52(sp)
+lw t5, 56(sp)
+lw t6, 60(sp)
+lw s0, 64(sp)
+lw s1, 68(sp)
+addi sp, sp, 80
+
+# retirq
+.insn r 0x0B, 0, 2, x0, x0, x0
+
+reset_vector:
 
 # zero-initialize register file
 addi x1, zero, 0
@@ -41,27 +124,57 @@ addi x31, zero, 0
 # addi x1, x1, 4
 # blt x1, sp, setmemloop
 
-# copy data section
+# copy data section (including RAMFUNC code in .ramfunc), four words per
+# iteration up to a4, then the remaining words one at a time
 la a0, _sidata
 la a1, _sdata
 la a2, _edata
-bge a1, a2, end_init_data
+sub t0, a2, a1
+andi t0, t0, 12
+sub a4, a2, t0
+bge a1, a4, init_data_words
 loop_init_data:
 lw a3, 0(a0)
+lw a5, 4(a0)
+lw a6, 8(a0)
+lw a7, 12(a0)
+sw a3, 0(a1)
+sw a5, 4(a1)
+sw a6, 8(a1)
+sw a7, 12(a1)
+addi a0, a0, 16
+addi a1, a1, 16
+blt a1, a4, loop_init_data
+init_data_words:
+bge a1, a2, end_init_data
+loop_init_data_word:
+lw a3, 0(a0)
 sw a3, 0(a1)
 addi a0, a0, 4
 addi a1, a1, 4
-blt a1, a2, loop_init_data
+blt a1, a2, loop_init_data_word
 end_init_data:
 
-# zero-init bss section
+# zero-init bss section, the same way
 la a0, _sbss
 la a1, _ebss
-bge a0, a1, end_init_bss
+sub t0, a1, a0
+andi t0, t0, 12
+sub a4, a1, t0
+bge a0, a4, init_bss_words
 loop_init_bss:
 sw zero, 0(a0)
+sw zero, 4(a0)
+sw zero, 8(a0)
+sw zero, 12(a0)
+addi a0, a0, 16
+blt a0, a4, loop_init_bss
+init_bss_words:
+bge a0, a1, end_init_bss
+loop_init_bss_word:
+sw zero, 0(a0)
 addi a0, a0, 4
-blt a0, a1, loop_init_bss
+blt a0, a1, loop_init_bss_word
 end_init_bss:
 
 # call main
@@ -79,8 +192,8 @@ flashio_worker_begin:
 # a1 ... data length
 # a2 ... optional WREN cmd (0 = disable)
 
-# address of SPI ctrl reg
-li   t0, 0x28000000
+# address of SPI ctrl reg (reg_spictrl)
+li   t0, 0x2d000000
 
 # Set CS high, IO0 is output
 li   t1, 0x120
@@ -157,3 +270,157 @@ ret
 .balign 4
 flashio_worker_end:
 
+.global flashmode_worker_begin
+.global flashmode_worker_end
+
+.balign 4
+
+# Switch the flash controller to another read mode and check that flash
+# reads still return the expected words.  Like flashio_worker this must be
+# copied to RAM and run from there, with IRQs masked.  The flash is taken
+# out of continuous read mode (IO0 high for 16 clocks) before the switch,
+# and again before the previous configuration is restored on a mismatch.
+
+flashmode_worker_begin:
+# a0 ... reg_spictrl value to try
+# a1 ... reference words (read in the current mode)
+# a2 ... number of words
+# a3 ... flash address of the reference words
+# a4 ... reg_spictrl value to restore on mismatch
+# returns the number of mismatching words in a0
+
+li   t0, 0x2d000000
+jal  a7, flashmode_worker_reset
+sw   a0, 0(t0)
+li   t3, 0
+
+# Two passes:  the second one restarts the read, which in continuous read
+# mode is sent without a command byte
+li   t6, 2
+flashmode_worker_L0:
+mv   t4, a1
+mv   t5, a3
+mv   a5, a2
+
+flashmode_worker_L1:
+beqz a5, flashmode_worker_L2
+lw   t1, 0(t4)
+lw   t2, 0(t5)
+beq  t1, t2, flashmode_worker_L3
+addi t3, t3, 1
+flashmode_worker_L3:
+addi t4, t4, 4
+addi t5, t5, 4
+addi a5, a5, -1
+j    flashmode_worker_L1
+
+flashmode_worker_L2:
+addi t6, t6, -1
+bnez t6, flashmode_worker_L0
+mv   a0, t3
+beqz t3, flashmode_worker_L5
+
+# Back to the previous configuration
+jal  a7, flashmode_worker_reset
+sw   a4, 0(t0)
+
+flashmode_worker_L5:
+ret
+
+# Manual mode, CS low, 16 clocks with IO0 high, CS high (returns to a7)
+flashmode_worker_reset:
+li   t1, 0x120
+sw   t1, 0(t0)
+li   t5, 16
+flashmode_worker_L4:
+li   t1, 0x101
+sw   t1, 0(t0)
+li   t1, 0x111
+sw   t1, 0(t0)
+addi t5, t5, -1
+bnez t5, flashmode_worker_L4
+li   t1, 0x121
+sw   t1, 0(t0)
+jr   a7
+.balign 4
+flashmode_worker_end:
+
+.global flashprog_worker_begin
+.global flashprog_worker_end
+
+.balign 4
+
+# Program or erase:  the flash cannot be read until it is done, so this
+# runs from RAM with IRQs masked like flashio_worker, and only returns to
+# memory mode once the busy bit has cleared.  The flash is taken out of
+# continuous read mode and sent WREN before the command.
+
+flashprog_worker_begin:
+# a0 ... command, address and data words (each MSB first)
+# a1 ... number of words
+# a2 ... maximum status polls
+# returns the busy bit (1 if the flash did not finish in time)
+
+li   t0, 0x2d000000
+
+# Set CS high, IO0 is output, manual mode
+li   t1, 0x120
+sh   t1, 0(t0)
+sb   zero, 3(t0)
+
+# 16 clocks with IO0 high, then WREN
+li   t3, -1
+li   t5, 16
+jal  a7, flashprog_worker_bits
+sb   t1, 0(t0)
+li   t3, 0x06000000
+li   t5, 8
+jal  a7, flashprog_worker_bits
+sb   t1, 0(t0)
+
+# Command, address and data, under one CS
+flashprog_worker_L1:
+lw   t3, 0(a0)
+li   t5, 32
+jal  a7, flashprog_worker_bits
+addi a0, a0, 4
+addi a1, a1, -1
+bnez a1, flashprog_worker_L1
+sb   t1, 0(t0)
+
+# Read status until the busy bit clears
+li   t3, 1
+flashprog_worker_L2:
+beqz a2, flashprog_worker_L3
+addi a2, a2, -1
+li   t3, 0x05000000
+li   t5, 16
+jal  a7, flashprog_worker_bits
+sb   t1, 0(t0)
+andi t3, t3, 1
+bnez t3, flashprog_worker_L2
+
+flashprog_worker_L3:
+# Back to MEMIO mode
+li   t1, 0x80
+sb   t1, 3(t0)
+mv   a0, t3
+ret
+
+# Clock out the top t5 bits of t3 (msb first) on IO0 with CS low, shifting
+# in IO1 from the bottom (returns to a7)
+flashprog_worker_bits:
+srli t4, t3, 31
+sb   t4, 0(t0)
+ori  t4, t4, 0x10
+sb   t4, 0(t0)
+lbu  t4, 0(t0)
+andi t4, t4, 2
+srli t4, t4, 1
+slli t3, t3, 1
+or   t3, t3, t4
+addi t5, t5, -1
+bnez t5, flashprog_worker_bits
+jr   a7
+.balign 4
+flashprog_worker_end:
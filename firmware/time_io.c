@@ -0,0 +1,220 @@
+#include "time_io.h"
+
+// Conversions avoid multiply and divide instructions (rv32i, no libgcc):
+// cycles per microsecond is kept in 1/16 units so the multiply by it is a
+// few shift-adds, and the rare cycles-to-time conversion uses shift-subtract.
+
+static uint32_t time_hz = TIME_CLOCK_HZ;
+static uint32_t time_cpus = (TIME_CLOCK_HZ / 1000000) << 4;	// cycles per us, x16
+static uint32_t time_cpms = TIME_CLOCK_HZ / 1000;		// cycles per ms
+
+static uint32_t time_mul(uint32_t a, uint32_t b)
+{
+    uint32_t p = 0;
+
+    while (b) {
+        if (b & 1)
+            p += a;
+        a <<= 1;
+        b >>= 1;
+    }
+    return p;
+}
+
+static uint32_t time_div(uint32_t n, uint32_t d, uint32_t *rem)
+{
+    uint32_t q = 0, r = 0;
+
+    for (int i = 0; i < 32; i++) {
+        r = (r << 1) | (n >> 31);
+        n <<= 1;
+        q <<= 1;
+        if (r >= d) {
+            r -= d;
+            q |= 1;
+        }
+    }
+    *rem = r;
+    return q;
+}
+
+static uint64_t time_div64(uint64_t n, uint32_t d)
+{
+    uint64_t q = 0;
+    uint32_t r = 0;
+
+    for (int i = 0; i < 64; i++) {
+        // r < d before the shift, so r fits in 33 bits; compare in 64
+        uint64_t t = ((uint64_t) r << 1) | (n >> 63);
+        n <<= 1;
+        q <<= 1;
+        if (t >= d) {
+            t -= d;
+            q |= 1;
+        }
+        r = (uint32_t) t;
+    }
+    return q;
+}
+
+/*
+ * time_set_clock()
+ * ----------------------------------------------------------------------------
+ * set the core clock frequency used by all conversions and delays
+ */
+void time_set_clock(uint32_t hz)
+{
+    uint32_t r;
+
+    time_hz = hz;
+    time_cpms = time_div(hz, 1000, &r);
+    time_cpus = time_div(hz, 62500, &r);	// hz / 1e6 * 16
+}
+
+uint32_t time_clock()
+{
+    return time_hz;
+}
+
+uint32_t time_cycles()
+{
+    uint32_t cycles;
+    __asm__ volatile ("rdcycle %0" : "=r"(cycles));
+    return cycles;
+}
+
+uint64_t time_cycles64()
+{
+    uint32_t lo, hi, hi2;
+
+    do {
+        __asm__ volatile ("rdcycleh %0" : "=r"(hi));
+        __asm__ volatile ("rdcycle %0" : "=r"(lo));
+        __asm__ volatile ("rdcycleh %0" : "=r"(hi2));
+    } while (hi != hi2);
+    return ((uint64_t) hi << 32) | lo;
+}
+
+/*
+ * time_elapsed()
+ * ----------------------------------------------------------------------------
+ * cycles since start (a time_cycles() value), correct across wrap-around
+ */
+uint32_t time_elapsed(uint32_t start)
+{
+    return time_cycles() - start;
+}
+
+uint32_t time_us_to_cycles(uint32_t us)
+{
+    return time_mul(us, time_cpus) >> 4;
+}
+
+uint32_t time_cycles_to_us(uint32_t cycles)
+{
+    uint32_t r, q;
+
+    q = time_div(cycles, time_cpus, &r);
+    return (q << 4) + time_div(r << 4, time_cpus, &r);
+}
+
+/*
+ * time_period_cycles()
+ * ----------------------------------------------------------------------------
+ * cycles in one period of a hz clock (clock / hz, rounded down)
+ */
+uint32_t time_period_cycles(uint32_t hz)
+{
+    uint32_t r;
+    return hz ? time_div(time_hz, hz, &r) : 0;
+}
+
+/*
+ * time_rate()
+ * ----------------------------------------------------------------------------
+ * events per second, for count events measured over the given cycles
+ */
+uint32_t time_rate(uint32_t count, uint32_t cycles)
+{
+    uint64_t n = 0, a = time_hz;
+
+    if (!cycles)
+        return 0;
+    while (count) {
+        if (count & 1)
+            n += a;
+        a <<= 1;
+        count >>= 1;
+    }
+    return (uint32_t) time_div64(n, cycles);
+}
+
+/*
+ * time_deadline_us()
+ * ----------------------------------------------------------------------------
+ * deadline us microseconds from now, for time_expired()
+ */
+uint32_t time_deadline_us(uint32_t us)
+{
+    return time_cycles() + time_us_to_cycles(us);
+}
+
+int time_expired(uint32_t deadline)
+{
+    return (int32_t) (time_cycles() - deadline) >= 0;
+}
+
+void delay_cycles(uint32_t cycles)
+{
+    uint32_t start = time_cycles();
+
+    while (time_cycles() - start < cycles)
+        ;
+}
+
+void delay_us(uint32_t us)
+{
+    delay_cycles(time_us_to_cycles(us));
+}
+
+void delay_ms(uint32_t ms)
+{
+    uint32_t start = time_cycles();
+
+    // One millisecond at a time, so long delays do not overflow
+    while (ms--) {
+        while (time_cycles() - start < time_cpms)
+            ;
+        start += time_cpms;
+    }
+}
+
+/*
+ * time_timebase_start()
+ * ----------------------------------------------------------------------------
+ * chain counter-timers 0 (low word) and 1 (high word) into a free-running
+ * 64-bit up-counter, independent of the core (keeps counting in waitirq)
+ */
+void time_timebase_start()
+{
+    reg_timer0_config = 0;
+    reg_timer1_config = 0;
+    reg_timer0_data = 0xffffffff;
+    reg_timer1_data = 0xffffffff;
+    reg_timer0_value = 0;
+    reg_timer1_value = 0;
+    reg_timer1_config = TIMER_ENABLE | TIMER_UPCOUNT | TIMER_CHAIN;
+    reg_timer0_config = TIMER_ENABLE | TIMER_UPCOUNT | TIMER_CHAIN;
+}
+
+uint64_t time_timebase()
+{
+    uint32_t lo, hi, hi2;
+
+    do {
+        hi = reg_timer1_value;
+        lo = reg_timer0_value;
+        hi2 = reg_timer1_value;
+    } while (hi != hi2);
+    return ((uint64_t) hi << 32) | lo;
+}
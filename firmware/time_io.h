@@ -0,0 +1,35 @@
+#ifndef TIME_IO_H
+#define TIME_IO_H
+
+#include "defs_mpw-two-mfix.h"
+
+// Core clock assumed until time_set_clock() is called (UART clkdiv 1042 =
+// 9600 baud at 10 MHz).  Set the measured value when the DCO is trimmed.
+#define TIME_CLOCK_HZ 10000000
+
+// Timer use:  the picorv32 timer IRQ belongs to print_io (UART drain);
+// counter-timers 0 and 1 are free unless time_timebase_start() chains
+// them into a 64-bit timebase.
+
+void time_set_clock(uint32_t hz);
+uint32_t time_clock();
+
+uint32_t time_cycles();
+uint64_t time_cycles64();
+uint32_t time_elapsed(uint32_t start);
+uint32_t time_us_to_cycles(uint32_t us);
+uint32_t time_cycles_to_us(uint32_t cycles);
+uint32_t time_period_cycles(uint32_t hz);
+uint32_t time_rate(uint32_t count, uint32_t cycles);
+
+uint32_t time_deadline_us(uint32_t us);
+int time_expired(uint32_t deadline);
+
+void delay_cycles(uint32_t cycles);
+void delay_us(uint32_t us);
+void delay_ms(uint32_t ms);
+
+void time_timebase_start();
+uint64_t time_timebase();
+
+#endif // TIME_IO_H
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+#
+# caravel_flashlog.py --- Read back the flash result log of flashlog_io.c.
+#
+# Usage:  caravel_flashlog.py [options]
+#
+# Reads the whole log region from the board in one streaming read (command
+# 0x03 through the housekeeping SPI pass-through, as caravel_hkflash.py
+# verifies), or from a flash image with --file:  a dump of the region, or
+# of the whole flash (the --flash-file of caravel_iss.py).  Best read while
+# the firmware is not writing to the log.
+#
+# Sectors with a valid header are put in sequence order and their records
+# printed oldest first, one line each:  sequence number, ring sector, offset
+# in the sector, type and payload words.  A record that fails its check
+# (a program cut short) ends its sector.  With --save, the region is also
+# written to a file for later runs with --file.
+#
+
+import argparse
+import struct
+import sys
+
+FLASHLOG_BASE = 0x300000
+FLASHLOG_SECTORS = 16
+SECTOR = 4096
+MAGIC = 0x31474c46          # "FLG1"
+HEADER_WORDS = 4
+RECORD_WORDS = 64
+ERASED = 0xffffffff
+
+CARAVEL_PASSTHRU = 0xc4
+CARAVEL_STREAM_READ = 0x40
+CMD_READ_LO_SPEED = 0x03
+
+
+def check(header, payload):
+    """
+    flashlog_check():  rotate-and-add over the header's low half and the
+    payload, folded to 16 bits.
+    """
+    s = 0x5a5a0000 | (header & 0xffff)
+    for w in payload:
+        s = (((s << 1) | (s >> 31)) + w) & 0xffffffff
+    return (s ^ (s >> 16)) & 0xffff
+
+
+def parse(region, sectors):
+    """
+    Return (records, notes):  records as (seq, sector, offset, type, payload)
+    in log order, notes on sectors that did not end cleanly.
+    """
+    found = []
+    for s in range(sectors):
+        words = struct.unpack_from('<{}I'.format(SECTOR // 4), region, s * SECTOR)
+        if words[0] == MAGIC and words[2] == words[1] ^ 0xffffffff and words[3] == sectors:
+            found.append((words[1], s, words))
+
+    records = []
+    notes = []
+    for seq, s, words in sorted(found):
+        pos = HEADER_WORDS
+        while pos < len(words) and words[pos] != ERASED:
+            header = words[pos]
+            n = header & 0xff
+            payload = words[pos + 1:pos + 1 + n]
+            if n > RECORD_WORDS or pos + 1 + n > len(words) or check(header, payload) != header >> 16:
+                notes.append('seq {} sector {}: bad record at offset {:#x}'.format(seq, s, pos * 4))
+                break
+            records.append((seq, s, pos * 4, (header >> 8) & 0xff, payload))
+            pos += 1 + n
+    return records, notes
+
+
+def read_board(base, size):
+    from io import StringIO
+    from pyftdi.ftdi import Ftdi
+    from pyftdi.spi import SpiController
+
+    s = StringIO()
+    Ftdi.show_devices(out=s)
+    gooddevs = []
+    for dev in s.getvalue().splitlines()[1:-1]:
+        url = dev.split('(')[0].strip()
+        name = '(' + dev.split('(')[1]
+        if name == '(Single RS232-HS)':
+            gooddevs.append(url)
+    if len(gooddevs) != 1:
+        raise ValueError('{} matching FTDI devices on the USB bus (need one)'.format(len(gooddevs)))
+
+    spi = SpiController(cs_count=2)
+    spi.configure(gooddevs[0])
+    slave = spi.get_port(cs=1, freq=12E6, mode=0)
+
+    mfg = slave.exchange([CARAVEL_STREAM_READ, 0x01], 2)
+    if int.from_bytes(mfg, byteorder='big') != 0x0456:
+        raise ValueError('no Caravel found (mfg {})'.format(mfg.hex()))
+
+    # leave continuous read mode (16 clocks with IO0 high), then one read
+    slave.write([CARAVEL_PASSTHRU, 0xff, 0xff])
+    read_cmd = bytearray((CARAVEL_PASSTHRU, CMD_READ_LO_SPEED,
+                          (base >> 16) & 0xff, (base >> 8) & 0xff, base & 0xff))
+    return bytes(slave.exchange(read_cmd, size))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='flashlog_io.c result log reader')
+    parser.add_argument('--file', help='read a region or whole-flash image instead of the board')
+    parser.add_argument('--save', help='write the log region to a file')
+    parser.add_argument('--base', type=lambda v: int(v, 0), default=FLASHLOG_BASE,
+                        help='flash offset of the log (FLASHLOG_BASE)')
+    parser.add_argument('--sectors', type=int, default=FLASHLOG_SECTORS,
+                        help='sectors in the ring (FLASHLOG_SECTORS)')
+    parser.add_argument('--type', type=lambda v: int(v, 0), help='only records of this type')
+    args = parser.parse_args()
+
+    size = args.sectors * SECTOR
+    try:
+        if args.file:
+            with open(args.file, 'rb') as f:
+                region = f.read()
+            if len(region) != size:
+                region = region[args.base:args.base + size]
+            if len(region) != size:
+                raise ValueError('{}: no {}-byte log region at {:#x}'.format(args.file, size, args.base))
+        else:
+            region = read_board(args.base, size)
+        if args.save:
+            with open(args.save, 'wb') as f:
+                f.write(region)
+        records, notes = parse(region, args.sectors)
+    except (OSError, ValueError) as e:
+        print('caravel_flashlog.py: ' + str(e), file=sys.stderr)
+        return 1
+
+    for seq, sector, offset, rtype, payload in records:
+        if args.type is None or rtype == args.type:
+            print('{:6} {:2} {:03x}  type {:3}  {}'.format(
+                seq, sector, offset, rtype, ' '.join('{:08x}'.format(w) for w in payload)))
+    for note in notes:
+        print(note)
+    print('{} records'.format(len(records)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
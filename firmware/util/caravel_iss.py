@@ -0,0 +1,1702 @@
+#!/usr/bin/env python3
+#
+# caravel_iss.py --- Instruction-set simulator for the Caravel management core.
+#
+# Usage:  caravel_iss.py [options] <file.elf | file.hex>
+#
+# Runs a firmware image the same way the board does:  the image is loaded
+# into the 4 MB SPI flash at 0x10000000, the core starts at start.s with sp
+# at the top of the 1 KB RAM, and start.s copies .data, clears .bss and calls
+# main().  The memory-mapped peripherals from defs.h are modelled closely
+# enough to run the example firmware without a board:
+#
+#   0x0100_0000  RAM (reg_rw_block0), 1 KB        0x2200_0000  counter-timer 0
+#   0x0110_0000  reg_rw_block1                    0x2300_0000  counter-timer 1
+#   0x0200_0000  reg_ro_block0                    0x2400_0000  SPI master
+#   0x1000_0000  SPI flash (XIP), 4 MB            0x2500_0000  logic analyzer
+#   0x2000_0000  UART                             0x2600_0000  user project control
+#   0x2100_0000  GPIO                             0x2d00_0000  flash SPI control
+#   0x2f00_0000  system area                      0x3000_0000  user project wishbone
+#
+# The core executes RV32IMC plus the picorv32 interrupt instructions.
+# Instruction counts are exact.  Cycle counts follow the picorv32 CPI table
+# (3 cycles for ALU ops and jal, 5 for loads, stores and taken branches, 6
+# for jalr, 4 for shifts, 40 for multiply and divide), plus the cycles the core waits for instruction
+# fetches from flash (modelled after the spimemio controller in the mode set
+# by reg_spictrl) and for the bus-stalling UART and SPI master.  They are
+# exact for the model, and a close estimate of the silicon.  rdcycle returns
+# the model cycle count, so cycle measurements made by the firmware itself
+# agree with the report.
+#
+# With --flash-file, the flash outside the image keeps what the firmware
+# programmed from one run to the next, as across resets of a board.
+#
+# The run stops at --max-cycles / --max-insns, when the pc reaches the
+# --until symbol, or when the core spins on a jump-to-self with nothing
+# left that could interrupt it (the "loop: j loop" after main returns).
+#
+
+import argparse
+import bisect
+import json
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import elf32
+
+FLASH_BASE = 0x10000000
+FLASH_SIZE = 0x400000
+RAM_BASE = 0x01000000
+RAM_SIZE = 0x400
+
+PROGADDR_RESET = FLASH_BASE
+PROGADDR_IRQ = FLASH_BASE + 0x10
+
+# picorv32 IRQ lines as wired in the management SoC
+IRQ_TIMER = 0
+IRQ_EBREAK = 1
+IRQ_BUSERROR = 2
+IRQ_GPIO7 = 7
+IRQ_GPIO8 = 8
+IRQ_SPI_MASTER = 9
+IRQ_COUNTER_TIMER0 = 10
+IRQ_COUNTER_TIMER1 = 11
+IRQ_USER0 = 12
+
+# Cycles per instruction (picorv32, dual-port register file, barrel shifter)
+CPI_ALU = 3
+CPI_SHIFT = 4
+CPI_LOAD = 5
+CPI_STORE = 5
+CPI_BRANCH = 3
+CPI_BRANCH_TAKEN = 5
+CPI_JAL = 3
+CPI_JALR = 6
+CPI_IRQ_ENTRY = 6
+
+# M extension through picorv32_pcpi_mul / picorv32_pcpi_div (ENABLE_MUL and
+# ENABLE_DIV, not ENABLE_FAST_MUL):  one result bit per cycle plus the
+# PCPI handshake
+CPI_MUL = 40
+CPI_DIV = 40
+
+# Wait states added to each access outside RAM and flash (wishbone ack)
+BUS_WAIT = 1
+
+NEVER = 1 << 62
+
+
+class SimError(Exception):
+    pass
+
+
+def sext(value, bits):
+    sign = 1 << (bits - 1)
+    return (value & (sign - 1)) - (value & sign)
+
+
+# ----------------------------------------------------------------------------
+# Compressed instructions
+# ----------------------------------------------------------------------------
+# RV32C instructions are expanded to the equivalent 32-bit encoding and then
+# decoded as usual.  picorv32 (COMPRESSED_ISA) executes them with the same
+# CPI as the full-size instruction.
+
+def enc_r(opcode, rd, f3, rs1, rs2, f7=0):
+    return f7 << 25 | rs2 << 20 | rs1 << 15 | f3 << 12 | rd << 7 | opcode
+
+
+def enc_i(opcode, rd, f3, rs1, imm):
+    return (imm & 0xfff) << 20 | rs1 << 15 | f3 << 12 | rd << 7 | opcode
+
+
+def enc_s(rs1, rs2, imm):
+    return ((imm >> 5) & 0x7f) << 25 | rs2 << 20 | rs1 << 15 | 2 << 12 | (imm & 0x1f) << 7 | 0x23
+
+
+def enc_b(f3, rs1, imm):
+    return (((imm >> 12) & 1) << 31 | ((imm >> 5) & 0x3f) << 25 | rs1 << 15 | f3 << 12 |
+            ((imm >> 1) & 0xf) << 8 | ((imm >> 11) & 1) << 7 | 0x63)
+
+
+def enc_j(rd, imm):
+    return (((imm >> 20) & 1) << 31 | ((imm >> 1) & 0x3ff) << 21 | ((imm >> 11) & 1) << 20 |
+            ((imm >> 12) & 0xff) << 12 | rd << 7 | 0x6f)
+
+
+def bits(ins, hi, lo):
+    return (ins >> lo) & ((1 << (hi - lo + 1)) - 1)
+
+
+def expand_compressed(c):
+    """
+    Return the 32-bit instruction for the 16-bit instruction c, or None if
+    it is not a valid RV32C instruction.
+    """
+    op, f3 = c & 3, c >> 13
+    rd = bits(c, 11, 7)
+    rs2 = bits(c, 6, 2)
+    rdp = bits(c, 4, 2) + 8
+    rs1p = bits(c, 9, 7) + 8
+    imm6 = sext(bits(c, 12, 12) << 5 | bits(c, 6, 2), 6)
+    jimm = sext(bits(c, 12, 12) << 11 | bits(c, 11, 11) << 4 | bits(c, 10, 9) << 8 |
+                bits(c, 8, 8) << 10 | bits(c, 7, 7) << 6 | bits(c, 6, 6) << 7 |
+                bits(c, 5, 3) << 1 | bits(c, 2, 2) << 5, 12)
+    bimm = sext(bits(c, 12, 12) << 8 | bits(c, 11, 10) << 3 | bits(c, 6, 5) << 6 |
+                bits(c, 4, 3) << 1 | bits(c, 2, 2) << 5, 9)
+    lwimm = bits(c, 12, 10) << 3 | bits(c, 6, 6) << 2 | bits(c, 5, 5) << 6
+
+    if op == 0:
+        if f3 == 0:
+            imm = (bits(c, 12, 11) << 4 | bits(c, 10, 7) << 6 |
+                   bits(c, 6, 6) << 2 | bits(c, 5, 5) << 3)
+            return enc_i(0x13, rdp, 0, 2, imm) if imm else None      # c.addi4spn
+        if f3 == 2:
+            return enc_i(0x03, rdp, 2, rs1p, lwimm)                  # c.lw
+        if f3 == 6:
+            return enc_s(rs1p, rdp, lwimm)                          # c.sw
+        return None
+    if op == 1:
+        if f3 == 0:
+            return enc_i(0x13, rd, 0, rd, imm6)                     # c.addi
+        if f3 == 1:
+            return enc_j(1, jimm)                                   # c.jal
+        if f3 == 2:
+            return enc_i(0x13, rd, 0, 0, imm6)                      # c.li
+        if f3 == 3:
+            if rd == 2:
+                imm = sext(bits(c, 12, 12) << 9 | bits(c, 6, 6) << 4 | bits(c, 5, 5) << 6 |
+                           bits(c, 4, 3) << 7 | bits(c, 2, 2) << 5, 10)
+                return enc_i(0x13, 2, 0, 2, imm) if imm else None   # c.addi16sp
+            return (imm6 << 12 & 0xfffff000) | rd << 7 | 0x37 if imm6 else None  # c.lui
+        if f3 == 4:
+            sub = bits(c, 11, 10)
+            if sub in (0, 1):
+                if c & 0x1000:
+                    return None
+                return enc_i(0x13, rs1p, 5, rs1p, rs2 | (0x400 if sub else 0))  # c.srli/srai
+            if sub == 2:
+                return enc_i(0x13, rs1p, 7, rs1p, imm6)             # c.andi
+            if c & 0x1000:
+                return None
+            f3r, f7 = ((0, 0x20), (4, 0), (6, 0), (7, 0))[bits(c, 6, 5)]
+            return enc_r(0x33, rs1p, f3r, rs1p, rdp, f7)            # c.sub/xor/or/and
+        if f3 == 5:
+            return enc_j(0, jimm)                                   # c.j
+        return enc_b(0 if f3 == 6 else 1, rs1p, bimm)              # c.beqz/bnez
+    if op == 2:
+        if f3 == 0:
+            return None if c & 0x1000 else enc_i(0x13, rd, 1, rd, rs2)   # c.slli
+        if f3 == 2:
+            imm = bits(c, 12, 12) << 5 | bits(c, 6, 4) << 2 | bits(c, 3, 2) << 6
+            return enc_i(0x03, rd, 2, 2, imm) if rd else None       # c.lwsp
+        if f3 == 4:
+            if not c & 0x1000:
+                if rs2 == 0:
+                    return enc_i(0x67, 0, 0, rd, 0) if rd else None # c.jr
+                return enc_r(0x33, rd, 0, 0, rs2)                   # c.mv
+            if rd == 0 and rs2 == 0:
+                return 0x00100073                                   # c.ebreak
+            if rs2 == 0:
+                return enc_i(0x67, 1, 0, rd, 0)                     # c.jalr
+            return enc_r(0x33, rd, 0, rd, rs2)                      # c.add
+        if f3 == 6:
+            imm = bits(c, 12, 9) << 2 | bits(c, 8, 7) << 6
+            return enc_s(2, rs2, imm)                               # c.swsp
+    return None
+
+
+# ----------------------------------------------------------------------------
+# Flash (XIP through spimemio)
+# ----------------------------------------------------------------------------
+
+class Flash:
+    """
+    Read-only flash with a fetch timing model.  The controller streams
+    consecutive words once a read has started, so sequential fetches only
+    wait for the next word; any jump (or a data load from flash) restarts
+    the read with the command, address and dummy cycles.
+
+    The part is a W25Q32 with only IO0/IO1 bonded out.  Reads in a mode it
+    cannot follow return corrupted data (and instruction fetches stop the
+    simulation):  quad modes, dual I/O with dummy cycles after the mode
+    bits, or any command sent while the part is in continuous read mode.
+    In manual mode (reg_spictrl bit 31 clear) the part answers JEDEC ID
+    (0x9f), read (0x03), read status (0x05), write enable (0x06), page
+    program (0x02) and sector erase (0x20) commands bit-banged through
+    reg_spictrl, and 16 clocks with IO0 high leave continuous read mode.
+    Programs and erases start when CSB goes high, keep the busy bit set
+    for the part's typical times (at the 10 MHz of time_io.h) and, as on
+    the part, program only clears bits.
+    """
+
+    JEDEC_ID = 0xef4016
+    PAGE = 256
+    SECTOR = 4096
+    PROGRAM_CYCLES = 7000       # 0.7 ms
+    ERASE_CYCLES = 450000       # 45 ms
+
+    def __init__(self, sim):
+        self.sim = sim
+        self.mem = bytearray(b'\xff' * FLASH_SIZE)
+        self.next_addr = -1
+        self.ready_at = 0
+        self.crm = False
+        self.clk = 0
+        self.io1 = 0
+        self.wel = False
+        self.busy_until = 0
+        self.select()
+
+    def select(self):
+        self.rx = 0
+        self.nbits = 0
+        self.cmd = None
+        self.tx = 0
+        self.tx_bits = 0
+        self.read_addr = None
+        self.prog = bytearray()
+
+    def busy(self):
+        return self.sim.now() < self.busy_until
+
+    def deselect(self):
+        """
+        CSB high:  run a complete program or erase command.
+        """
+        if self.cmd in (0x02, 0x20) and self.nbits >= 32 and self.wel and not self.busy():
+            addr = self.prog_addr
+            if self.cmd == 0x02:
+                page = addr & ~(self.PAGE - 1)
+                for i, b in enumerate(self.prog[-self.PAGE:]):
+                    self.mem[page + ((addr + i) & (self.PAGE - 1))] &= b
+                self.busy_until = self.sim.now() + self.PROGRAM_CYCLES
+            else:
+                sector = addr & ~(self.SECTOR - 1)
+                self.mem[sector:sector + self.SECTOR] = b'\xff' * self.SECTOR
+                self.busy_until = self.sim.now() + self.ERASE_CYCLES
+            self.wel = False
+        self.select()
+
+    def mode_ok(self):
+        ctrl = self.sim.spictrl.ctrl
+        dual = ctrl & 0x00400000
+        qspi = ctrl & 0x00200000
+        crm = ctrl & 0x00100000
+        dummy = (ctrl >> 16) & 0xf
+        if qspi:
+            return False
+        if dual:
+            return dummy == 0 and (crm or not self.crm)
+        return not self.crm
+
+    def read_word(self, addr):
+        word = struct.unpack_from('<I', self.mem, (addr - FLASH_BASE) & ~3)[0]
+        if not self.mode_ok():
+            word = ((word >> 1) | (word << 31)) & 0xffffffff
+        return word
+
+    def pins(self, value):
+        """
+        Manual mode:  CSB (bit 5), CLK (bit 4) and IO0 (bit 0) from the
+        host, IO1 back to it.  SPI mode 0, MSB first.
+        """
+        clk = (value >> 4) & 1
+        if value & 0x20:
+            self.deselect()
+        elif clk and not self.clk:
+            self.rx = ((self.rx << 1) | (value & 1)) & 0xffffffff
+            self.nbits += 1
+            self.command()
+        elif not clk and self.clk:
+            if not self.tx_bits and self.read_addr is not None:
+                self.tx = self.mem[self.read_addr & (FLASH_SIZE - 1)]
+                self.tx_bits = 8
+                self.read_addr += 1
+            elif not self.tx_bits and self.cmd == 0x05:
+                self.tx = (1 if self.busy() else 0) | (2 if self.wel else 0)
+                self.tx_bits = 8
+            if self.tx_bits:
+                self.tx_bits -= 1
+                self.io1 = (self.tx >> self.tx_bits) & 1
+        self.clk = clk
+
+    def command(self):
+        if self.crm:
+            if self.nbits == 16 and self.rx & 0xffff == 0xffff:
+                self.crm = False
+            return
+        if self.nbits == 8:
+            self.cmd = self.rx & 0xff
+            if self.cmd == 0x9f:
+                self.tx, self.tx_bits = self.JEDEC_ID, 24
+            elif self.cmd == 0x06 and not self.busy():
+                self.wel = True
+        elif self.cmd == 0x03 and self.nbits == 32:
+            self.read_addr = self.rx & 0xffffff
+        elif self.cmd in (0x02, 0x20) and self.nbits == 32:
+            self.prog_addr = self.rx & (FLASH_SIZE - 1)
+        elif self.cmd == 0x02 and self.nbits > 32 and not self.nbits & 7:
+            self.prog.append(self.rx & 0xff)
+
+    def timing(self):
+        ctrl = self.sim.spictrl.ctrl
+        ddr = ctrl & 0x00400000
+        qspi = ctrl & 0x00200000
+        crm = ctrl & 0x00100000
+        dummy = (ctrl >> 16) & 0xf
+
+        # spimemio runs the flash clock at half the core clock
+        if qspi and ddr:
+            word, setup = 8, 6 + 4
+        elif qspi:
+            word, setup = 16, 12 + 4
+        elif ddr:
+            word, setup = 32, 24 + 8
+        else:
+            word, setup, dummy = 64, 48, 0
+        if not crm or not (qspi or ddr):
+            setup += 16
+        return word, setup + 2 * dummy + 2
+
+    def access(self, addr, now, fetch=False):
+        """
+        Return the cycles the core waits for the word containing addr.
+        """
+        ctrl = self.sim.spictrl.ctrl
+        if not ctrl & 0x80000000:
+            raise SimError('flash access at {:08x} with MEMIO disabled'.format(addr))
+        if fetch and not self.mode_ok():
+            raise SimError('instruction fetch from {:08x} in a flash mode the part '
+                           'does not follow (reg_spictrl {:08x})'.format(addr, ctrl))
+        if ctrl & 0x00500000 == 0x00500000 and self.mode_ok():
+            self.crm = True
+        addr &= ~3
+        if addr == self.next_addr - 4:
+            return 0
+        word, setup = self.timing()
+        if addr == self.next_addr:
+            start = max(now, self.ready_at)
+        else:
+            start = now + setup + word
+        self.next_addr = addr + 4
+        self.ready_at = start + word
+        return start - now
+
+
+# ----------------------------------------------------------------------------
+# Peripherals
+# ----------------------------------------------------------------------------
+
+class Device:
+    """
+    A block of 32-bit registers.  Byte and halfword accesses are merged
+    into the enclosing word.
+    """
+    name = 'device'
+
+    def __init__(self, sim):
+        self.sim = sim
+
+    def read(self, off):
+        raise SimError('read from unmapped {} register +{:x}'.format(self.name, off))
+
+    def write(self, off, value):
+        raise SimError('write to unmapped {} register +{:x}'.format(self.name, off))
+
+    def trace(self, reg, value):
+        self.sim.trace(self.name, reg, value)
+
+
+class Memory(Device):
+    def __init__(self, sim, name, size, writable=True):
+        super().__init__(sim)
+        self.name = name
+        self.mem = bytearray(size)
+        self.writable = writable
+
+    def read(self, off):
+        if off + 4 > len(self.mem):
+            return super().read(off)
+        return struct.unpack_from('<I', self.mem, off)[0]
+
+    def write(self, off, value):
+        if not self.writable or off + 4 > len(self.mem):
+            return super().write(off, value)
+        struct.pack_into('<I', self.mem, off, value)
+
+
+class Uart(Device):
+    """
+    simpleuart:  a write to the data register sends one character and
+    stalls the bus while the previous character is still shifting out.
+    """
+    name = 'uart'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.clkdiv = 1
+        self.enable = 0
+        self.busy_until = 0
+        self.output = bytearray()
+
+    def read(self, off):
+        if off == 0x0:
+            return self.clkdiv
+        if off == 0x4:
+            return 0xffffffff  # no receive data
+        if off == 0x8:
+            return self.enable
+        return super().read(off)
+
+    def write(self, off, value):
+        if off == 0x0:
+            self.clkdiv = value
+        elif off == 0x4:
+            if self.enable:
+                now = self.sim.now()
+                start = max(now, self.busy_until)
+                self.sim.stall(start - now)
+                self.busy_until = start + 10 * max(self.clkdiv, 1)
+                self.output.append(value & 0xff)
+                if self.sim.uart_echo:
+                    sys.stdout.write(chr(value & 0xff))
+                    sys.stdout.flush()
+        elif off == 0x8:
+            self.enable = value & 1
+        else:
+            super().write(off, value)
+
+
+class Gpio(Device):
+    name = 'gpio'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.regs = [0, 0, 0, 0]
+
+    def read(self, off):
+        if off < 0x10:
+            return self.regs[off >> 2]
+        return super().read(off)
+
+    def write(self, off, value):
+        if off >= 0x10:
+            return super().write(off, value)
+        if off == 0 and value != self.regs[0]:
+            self.trace('data', value)
+        self.regs[off >> 2] = value
+
+
+class CounterTimer(Device):
+    """
+    Counter-timer:  counts down to zero (or up to the data register with
+    TIMER_UPCOUNT), then stops (TIMER_ONESHOT) or reloads, raising its IRQ
+    with TIMER_IRQ_ENABLE.  With TIMER_CHAIN set on both timers, timer 1
+    holds the upper 32 bits of a 64-bit count and raises the IRQ.
+    """
+
+    def __init__(self, sim, index, irq):
+        super().__init__(sim)
+        self.name = 'timer{}'.format(index)
+        self.index = index
+        self.irq = irq
+        self.config = 0
+        self.value = 0
+        self.data = 0
+        self.stopped = False
+
+    def read(self, off):
+        self.sim.timers_update()
+        if off == 0x0:
+            return self.config
+        if off == 0x4:
+            return self.value
+        if off == 0x8:
+            return self.data
+        return super().read(off)
+
+    def write(self, off, value):
+        self.sim.timers_update()
+        if off == 0x0:
+            self.config = value & 0x1f
+            self.stopped = False
+        elif off == 0x4:
+            self.value = value
+            self.stopped = False
+        elif off == 0x8:
+            self.data = value
+        else:
+            return super().write(off, value)
+        self.sim.timers_reschedule()
+
+
+def timer_advance(config, value, data, bits, n, stopped):
+    """
+    Advance a counter by n cycles.  Returns (value, fired, stopped, next),
+    where next is the number of cycles until it fires again (NEVER if it
+    cannot).
+    """
+    mask = (1 << bits) - 1
+    fired = 0
+    up = config & 0x04
+    oneshot = config & 0x02
+    if not config & 0x01 or stopped:
+        return value, 0, stopped, NEVER
+
+    while n > 0:
+        if up:
+            steps = (data - value) & mask if value != data else 0
+        else:
+            steps = value
+        if steps == 0:
+            # At the terminal count: stop, or reload on the next cycle
+            if oneshot:
+                stopped = True
+                return value, fired, stopped, NEVER
+            value = 0 if up else data
+            n -= 1
+            continue
+        if n < steps:
+            value = (value + n) & mask if up else value - n
+            return value, fired, stopped, steps - n
+        n -= steps
+        value = data if up else 0
+        fired += 1
+        if oneshot:
+            stopped = True
+            return value, fired, stopped, NEVER
+
+    if up:
+        steps = (data - value) & mask if value != data else (0 if oneshot else 1 + (data & mask))
+    else:
+        steps = value if value else (NEVER if oneshot else 1 + data)
+    return value, fired, stopped, steps if steps else NEVER
+
+
+class SpiMaster(Device):
+    """
+    SPI master:  a data write starts an 8-bit transfer; any access to the
+    data register while a transfer is running stalls the bus until it ends.
+    MISO is modelled as loopback (--spi-loopback) or idle high.
+    """
+    name = 'spi'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.config = 0
+        self.rx = 0xff
+        self.done_at = 0
+
+    def wait(self):
+        now = self.sim.now()
+        if now < self.done_at:
+            self.sim.stall(self.done_at - now)
+
+    def read(self, off):
+        if off == 0x0:
+            return self.config
+        if off == 0x4:
+            self.wait()
+            return self.rx
+        return super().read(off)
+
+    def write(self, off, value):
+        if off == 0x0:
+            self.config = value & 0xffff
+        elif off == 0x4:
+            self.wait()
+            if self.config & 0x2000:
+                div = max(self.config & 0xff, 1)
+                self.done_at = self.sim.now() + 16 * div
+                self.rx = value & 0xff if self.sim.spi_loopback else 0xff
+                self.trace('data', value & 0xff)
+                if self.config & 0x4000:
+                    self.sim.schedule(self.done_at, IRQ_SPI_MASTER)
+        else:
+            super().write(off, value)
+
+
+class LogicAnalyzer(Device):
+    """
+    128 LA bits.  Bits with oenb = 0 are driven by the management core and
+    read back what was written; bits with oenb = 1 read the user project
+    side, taken from --la-in or a user model.
+    """
+    name = 'la'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.data = [0] * 4
+        self.oenb = [0xffffffff] * 4
+        self.iena = [0xffffffff] * 4
+        self.sample = 0
+
+    def read(self, off):
+        i = (off >> 2) & 3
+        if off < 0x10:
+            user = self.sim.user.la_in(i)
+            return (self.data[i] & ~self.oenb[i] | user & self.oenb[i]) & 0xffffffff
+        if off < 0x20:
+            return self.oenb[i]
+        if off < 0x30:
+            return self.iena[i]
+        if off == 0x30:
+            return self.sample
+        return super().read(off)
+
+    def write(self, off, value):
+        i = (off >> 2) & 3
+        if off < 0x10:
+            self.data[i] = value
+            self.trace('data{}'.format(i), value)
+            self.sim.user.la_out(i, value, self.oenb[i])
+        elif off < 0x20:
+            self.oenb[i] = value
+        elif off < 0x30:
+            self.iena[i] = value
+        elif off == 0x30:
+            self.sample = value
+        else:
+            super().write(off, value)
+
+
+class ProjectControl(Device):
+    """
+    User project control:  GPIO pad configuration (reg_mprj_io_*), the
+    serial transfer that loads it into the pads (reg_mprj_xfer), and the
+    management-side pad data registers.
+    """
+    name = 'mprj'
+    XFER_CYCLES = 2 * 13 * 19 + 16
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.xfer_done = 0
+        self.pwr = 0
+        self.irq = 0
+        self.datal = 0
+        self.datah = 0
+        self.io = [0] * 38
+        self.xfers = 0
+
+    def read(self, off):
+        if off == 0x00:
+            return 1 if self.sim.now() < self.xfer_done else 0
+        if off == 0x04:
+            return self.pwr
+        if off == 0x08:
+            return self.irq
+        if off == 0x0c:
+            return self.sim.user.pads_in(0, self.datal)
+        if off == 0x10:
+            return self.sim.user.pads_in(1, self.datah)
+        if 0x24 <= off < 0x24 + 4 * 38:
+            return self.io[(off - 0x24) >> 2]
+        return super().read(off)
+
+    def write(self, off, value):
+        if off == 0x00:
+            if value & 1:
+                self.xfer_done = self.sim.now() + self.XFER_CYCLES
+                self.xfers += 1
+                self.trace('xfer', value)
+        elif off == 0x04:
+            self.pwr = value
+        elif off == 0x08:
+            self.irq = value
+        elif off == 0x0c:
+            self.sim.user.pads_out(0, self.datal)
+            self.datal = value
+            self.trace('datal', value)
+        elif off == 0x10:
+            self.sim.user.pads_out(1, self.datah)
+            self.datah = value & 0x3f
+            self.trace('datah', value)
+        elif 0x24 <= off < 0x24 + 4 * 38:
+            self.io[(off - 0x24) >> 2] = value & 0x1fff
+        else:
+            super().write(off, value)
+
+
+class SpiCtrl(Device):
+    """
+    Flash SPI controller configuration (reg_spictrl).  Reset value: memory
+    mode, standard SPI, 8 dummy cycles.
+    """
+    name = 'spictrl'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.ctrl = 0x80080000
+
+    def read(self, off):
+        if off == 0:
+            if not self.ctrl & 0x80000000:
+                return (self.ctrl & ~2) | (self.sim.flash.io1 << 1)
+            return self.ctrl
+        return super().read(off)
+
+    def write(self, off, value):
+        if off == 0:
+            if (value ^ self.ctrl) & 0x807f0000:
+                self.trace('ctrl', value)
+            self.ctrl = value
+            self.sim.flash.next_addr = -1
+            if not value & 0x80000000:
+                self.sim.flash.pins(value)
+        else:
+            super().write(off, value)
+
+
+class SystemArea(Device):
+    name = 'system'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.regs = [0x0f, 0, 0, 0]  # all user power supplies good
+
+    def read(self, off):
+        if off < 0x10:
+            return self.regs[off >> 2]
+        return super().read(off)
+
+    def write(self, off, value):
+        if 0 < off < 0x10:
+            self.regs[off >> 2] = value
+        else:
+            super().write(off, value)
+
+
+# ----------------------------------------------------------------------------
+# User project models (wishbone window at 0x3000_0000, LA inputs, pad inputs)
+# ----------------------------------------------------------------------------
+
+class UserProject(Device):
+    """
+    Default user project:  the wishbone window behaves as plain memory,
+    LA inputs come from --la-in and pad inputs from --pads-in.
+    """
+    name = 'user'
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.mem = {}
+
+    def read(self, off):
+        return self.mem.get(off, 0)
+
+    def write(self, off, value):
+        self.mem[off] = value
+
+    def la_in(self, i):
+        return (self.sim.la_in >> (32 * i)) & 0xffffffff
+
+    def la_out(self, i, value, oenb):
+        pass
+
+    def pads_in(self, i, value):
+        return value
+
+    def pads_out(self, i, value):
+        """
+        Called before the management side changes reg_mprj_datal (i = 0) or
+        datah (1); value is the word the pads held until now.
+        """
+        pass
+
+
+class WakeyProject(UserProject):
+    """
+    Wakey Wakey configuration interface (see wakey/wakey.c):  address,
+    control and four byte-wide data lanes.  Control 0x1 stores the data
+    lanes at the address, 0x2 loads them back.
+
+    PDM front end:  the PDM clock on IO[35] runs at PDM_CLK_CYCLES core
+    cycles per period and IO[36] is sampled on its rising edge while
+    ctl_pipeline_en (LA bit 0) is set.  The network is stood in for by an
+    energy detector:  64-bit PCM sums, a loud run of WORD_SAMPLES or more
+    that ends raises wake (IO[37], LA bit 118) WAKE_DELAY samples later.
+    Clearing ctl_pipeline_en resets the pipeline and wake.
+    """
+    name = 'wakey'
+    PDM_CLK_CYCLES = 512
+    WORD_SAMPLES = 32
+    WAKE_DELAY = 4
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.addr = 0
+        self.lanes = [0, 0, 0, 0]
+        self.cfg = {}
+        self.pipeline_en = 0
+        self.pdm_edge = 0
+        self.pdm_reset()
+
+    def pdm_reset(self):
+        self.ones = 0
+        self.nbits = 0
+        self.energy = 0
+        self.loud_run = 0
+        self.fire = 0
+        self.wake = 0
+
+    def pdm_sample(self, bit):
+        self.ones += bit
+        self.nbits += 1
+        if self.nbits < 64:
+            return
+        level = self.ones - 32
+        self.ones = 0
+        self.nbits = 0
+        self.energy += abs(level) - (self.energy >> 3)
+        if self.energy > 64:
+            self.loud_run += 1
+            return
+        if self.loud_run >= self.WORD_SAMPLES and not self.wake:
+            self.fire = self.WAKE_DELAY
+        self.loud_run = 0
+        if self.fire:
+            self.fire -= 1
+            if not self.fire:
+                self.wake = 1
+                self.trace('wake', 1)
+
+    def pdm_advance(self, datah):
+        """
+        Sample IO[36] at every rising PDM clock edge up to now, with the
+        pads as they were since the last change.
+        """
+        now = self.sim.now()
+        while self.pdm_edge <= now:
+            if self.pipeline_en:
+                self.pdm_sample((datah >> 4) & 1)
+            self.pdm_edge += self.PDM_CLK_CYCLES
+
+    def pdm_clock(self):
+        return 1 if self.sim.now() % self.PDM_CLK_CYCLES < self.PDM_CLK_CYCLES >> 1 else 0
+
+    def la_in(self, i):
+        value = super().la_in(i)
+        if i == 3:
+            self.pdm_advance(self.sim.mprj.datah)
+            value = value & ~(1 << 22) | (self.wake << 22)
+        return value
+
+    def la_out(self, i, value, oenb):
+        # the board drives ctl_pipeline_en with the LA output enable off
+        # (see wakey.c), so the data bit is taken as is
+        if i == 0:
+            self.pdm_advance(self.sim.mprj.datah)
+            if not value & 1:
+                self.pdm_reset()
+            self.pipeline_en = value & 1
+
+    def pads_in(self, i, value):
+        if i == 1:
+            self.pdm_advance(value)
+            value = value & ~0x28 | (self.pdm_clock() << 3) | (self.wake << 5)
+        return value
+
+    def pads_out(self, i, value):
+        if i == 1:
+            self.pdm_advance(value)
+
+    def read(self, off):
+        if off == 0x00:
+            return self.addr
+        if 0x08 <= off < 0x18:
+            return self.lanes[(off - 0x08) >> 2]
+        return super().read(off)
+
+    def write(self, off, value):
+        if off == 0x00:
+            self.addr = value
+        elif off == 0x04:
+            if value == 0x1:
+                self.cfg[self.addr] = list(self.lanes)
+            elif value == 0x2:
+                self.lanes = list(self.cfg.get(self.addr, [0, 0, 0, 0]))
+        elif 0x08 <= off < 0x18:
+            self.lanes[(off - 0x08) >> 2] = value & 0xff
+        else:
+            super().write(off, value)
+
+
+class MailboxProject(UserProject):
+    """
+    Loopback for the LA mailbox (see la_mailbox_io.h):  TX words are taken
+    into a FIFO of FIFO_DEPTH words as soon as TX_REQ toggles, and handed
+    back one by one on the RX lane.  When the FIFO is full, TX_ACK waits
+    until the management core reads a word.
+    """
+    name = 'mailbox'
+    FIFO_DEPTH = 64
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.fifo = []
+        self.tx_data = 0
+        self.tx_req = 0
+        self.tx_ack = 0
+        self.rx_data = 0
+        self.rx_req = 0
+        self.rx_ack = 0
+
+    def update(self):
+        while True:
+            if self.tx_req != self.tx_ack and len(self.fifo) < self.FIFO_DEPTH:
+                self.fifo.append(self.tx_data)
+                self.tx_ack = self.tx_req
+            elif self.rx_req == self.rx_ack and self.fifo:
+                self.rx_data = self.fifo.pop(0)
+                self.rx_req ^= 1
+            else:
+                return
+
+    def la_in(self, i):
+        value = super().la_in(i)
+        if i == 1:
+            value = self.rx_data
+        elif i == 2:
+            value = value & ~0x30000 | (self.tx_ack << 16) | (self.rx_req << 17)
+        return value
+
+    def la_out(self, i, value, oenb):
+        if i == 0:
+            self.tx_data = value
+        elif i == 2:
+            self.tx_req = value & 1
+            self.rx_ack = (value >> 1) & 1
+            self.update()
+
+
+class IrqLoopProject(UserProject):
+    """
+    User IRQ loopback:  the management core drives LA bits 96-98 (LA word
+    3, bits 0-2) and the user project raises user_irq[0-2] (IRQ_USER0-2)
+    on their rising edges, if the line is enabled in reg_mprj_irq.
+    """
+    name = 'irqloop'
+    IRQ_USER0 = 12
+
+    def __init__(self, sim):
+        super().__init__(sim)
+        self.lines = 0
+
+    def la_out(self, i, value, oenb):
+        if i != 3:
+            return
+        lines = value & ~oenb & 7
+        rise = lines & ~self.lines & self.sim.mprj.irq
+        self.lines = lines
+        for n in range(3):
+            if rise & (1 << n):
+                self.sim.raise_irq(self.IRQ_USER0 + n)
+
+
+class ClockGenProject(UserProject):
+    """
+    Test clock on IO[15]:  rising edges every PERIOD cycles, moved by up to
+    +-JITTER cycles (a fixed pseudo-random sequence), high for DUTY / 256
+    of the period.
+    """
+    name = 'clockgen'
+    PAD = 15
+    PERIOD = 2000
+    JITTER = 8
+    DUTY = 77
+
+    def rise(self, k):
+        h = (k * 2654435761) & 0xffffffff
+        return k * self.PERIOD + (h >> 16) % (2 * self.JITTER + 1) - self.JITTER
+
+    def level(self):
+        now = self.sim.now()
+        k = now // self.PERIOD
+        for m in (k, k + 1):
+            r = self.rise(m)
+            if r <= now < r + ((self.PERIOD * self.DUTY) >> 8):
+                return 1
+        return 0
+
+    def pads_in(self, i, value):
+        if i == self.PAD >> 5:
+            bit = 1 << (self.PAD & 31)
+            value = value & ~bit | (bit if self.level() else 0)
+        return value
+
+
+USER_MODELS = {'ram': UserProject, 'wakey': WakeyProject, 'mailbox': MailboxProject,
+               'irqloop': IrqLoopProject, 'clockgen': ClockGenProject}
+
+
+# ----------------------------------------------------------------------------
+# Core
+# ----------------------------------------------------------------------------
+
+class Sim:
+    def __init__(self, user_model='ram', la_in=0, spi_loopback=False,
+                 uart_echo=False, trace_io=False):
+        self.regs = [0] * 32
+        self.pc = PROGADDR_RESET
+        self.cycles = 0
+        self.instret = 0
+        self.extra = 0
+        self.decoded = {}
+
+        self.la_in = la_in
+        self.spi_loopback = spi_loopback
+        self.uart_echo = uart_echo
+        self.trace_io = trace_io
+        self.events = []
+
+        # picorv32 interrupt state (ENABLE_IRQ_QREGS = 0: return address
+        # in x3, pending mask in x4)
+        self.irq_mask = 0xffffffff
+        self.irq_pending = 0
+        self.irq_active = False
+        self.irq_timer = 0
+        self.irq_timer_at = NEVER
+        self.scheduled = []
+        self.next_event = NEVER
+
+        self.flash = Flash(self)
+        self.ram = Memory(self, 'ram', RAM_SIZE)
+        self.rw_block1 = Memory(self, 'rw_block1', RAM_SIZE)
+        self.ro_block0 = Memory(self, 'ro_block0', RAM_SIZE, writable=False)
+        self.uart = Uart(self)
+        self.gpio = Gpio(self)
+        self.timer0 = CounterTimer(self, 0, IRQ_COUNTER_TIMER0)
+        self.timer1 = CounterTimer(self, 1, IRQ_COUNTER_TIMER1)
+        self.timer_sync = 0
+        self.timer_next = NEVER
+        self.spi = SpiMaster(self)
+        self.la = LogicAnalyzer(self)
+        self.mprj = ProjectControl(self)
+        self.spictrl = SpiCtrl(self)
+        self.system = SystemArea(self)
+        self.user = USER_MODELS[user_model](self)
+
+        # Address decode on bits 31:20
+        self.devices = {
+            0x010: self.ram,
+            0x011: self.rw_block1,
+            0x020: self.ro_block0,
+            0x200: self.uart,
+            0x210: self.gpio,
+            0x220: self.timer0,
+            0x230: self.timer1,
+            0x240: self.spi,
+            0x250: self.la,
+            0x260: self.mprj,
+            0x280: self.spictrl,
+            0x2d0: self.spictrl,
+            0x2f0: self.system,
+        }
+        for i in range(0x300, 0x400):
+            self.devices[i] = self.user
+
+        self.regs[2] = RAM_BASE + RAM_SIZE
+
+        self.symbols = []
+        self.symbol_addrs = []
+
+    # ---- Loading ----
+
+    def load_elf(self, path):
+        elf = elf32.Elf32(path)
+        for p in elf.segments:
+            if p.type != elf32.PT_LOAD or p.filesz == 0:
+                continue
+            self.load_image(p.paddr, elf.segment_data(p))
+        self.symbols = sorted(elf.functions(), key=lambda s: s[1])
+        self.symbol_addrs = [s[1] for s in self.symbols]
+        self.symtab = {s.name: s.value for s in elf.symbols if s.name}
+
+    def load_hex(self, path):
+        """
+        objcopy -O verilog output, with the flash at @10000000 or (after the
+        Makefile's sed) at @00000000.
+        """
+        addr = 0
+        with open(path) as f:
+            for line in f:
+                line = line.strip()
+                if not line:
+                    continue
+                if line.startswith('@'):
+                    addr = int(line[1:], 16)
+                    if addr < FLASH_SIZE:
+                        addr += FLASH_BASE
+                    continue
+                data = bytes(int(b, 16) for b in line.split())
+                self.load_image(addr, data)
+                addr += len(data)
+        self.symtab = {}
+
+    def load_image(self, addr, data):
+        if FLASH_BASE <= addr and addr + len(data) <= FLASH_BASE + FLASH_SIZE:
+            off = addr - FLASH_BASE
+            self.flash.mem[off:off + len(data)] = data
+        elif RAM_BASE <= addr and addr + len(data) <= RAM_BASE + RAM_SIZE:
+            off = addr - RAM_BASE
+            self.ram.mem[off:off + len(data)] = data
+        else:
+            raise SimError('cannot load {} bytes at {:08x}'.format(len(data), addr))
+
+    def symbolize(self, addr):
+        i = bisect.bisect_right(self.symbol_addrs, addr) - 1
+        if i < 0:
+            return '{:08x}'.format(addr)
+        name, base, _ = self.symbols[i]
+        return '{}+0x{:x}'.format(name, addr - base) if addr != base else name
+
+    # ---- Time and events ----
+
+    def now(self):
+        return self.cycles + self.extra
+
+    def stall(self, n):
+        self.extra += n
+
+    def trace(self, dev, reg, value):
+        if self.trace_io:
+            self.events.append((self.now(), dev, reg, value))
+
+    def raise_irq(self, irq):
+        self.irq_pending |= 1 << irq
+
+    def schedule(self, cycle, irq):
+        self.scheduled.append((cycle, irq))
+        self.next_event = min(self.next_event, cycle)
+
+    def timers_update(self):
+        now = self.now()
+        n = now - self.timer_sync
+        self.timer_sync = now
+        if n <= 0:
+            return
+        t0, t1 = self.timer0, self.timer1
+        if t0.config & t1.config & 0x08:
+            value = t1.value << 32 | t0.value
+            data = t1.data << 32 | t0.data
+            value, fired, t0.stopped, nxt = timer_advance(
+                t0.config, value, data, 64, n, t0.stopped)
+            t0.value, t1.value = value & 0xffffffff, value >> 32
+            if fired and (t0.config | t1.config) & 0x10:
+                self.raise_irq(t1.irq)
+            self.timer_next = now + nxt if nxt != NEVER else NEVER
+            return
+        self.timer_next = NEVER
+        for t in (t0, t1):
+            t.value, fired, t.stopped, nxt = timer_advance(
+                t.config, t.value, t.data, 32, n, t.stopped)
+            if fired and t.config & 0x10:
+                self.raise_irq(t.irq)
+            if nxt != NEVER and t.config & 0x10:
+                self.timer_next = min(self.timer_next, now + nxt)
+
+    def timers_reschedule(self):
+        # Advancing by zero cycles recomputes when the next IRQ is due
+        t0, t1 = self.timer0, self.timer1
+        now = self.now()
+        self.timer_next = NEVER
+        if t0.config & t1.config & 0x08:
+            _, _, _, nxt = timer_advance(t0.config, t1.value << 32 | t0.value,
+                                         t1.data << 32 | t0.data, 64, 0, t0.stopped)
+            if nxt != NEVER and (t0.config | t1.config) & 0x10:
+                self.timer_next = now + nxt
+        else:
+            for t in (t0, t1):
+                _, _, _, nxt = timer_advance(t.config, t.value, t.data, 32, 0, t.stopped)
+                if nxt != NEVER and t.config & 0x10:
+                    self.timer_next = min(self.timer_next, now + nxt)
+        self.update_next_event()
+
+    def update_next_event(self):
+        nxt = min(self.timer_next, self.irq_timer_at)
+        for cycle, _ in self.scheduled:
+            nxt = min(nxt, cycle)
+        self.next_event = nxt
+
+    def service_events(self):
+        now = self.now()
+        if self.timer_next <= now:
+            self.timers_update()
+        if self.irq_timer_at <= now:
+            self.irq_timer_at = NEVER
+            self.irq_timer = 0
+            self.raise_irq(IRQ_TIMER)
+        if self.scheduled:
+            due = [e for e in self.scheduled if e[0] <= now]
+            self.scheduled = [e for e in self.scheduled if e[0] > now]
+            for _, irq in due:
+                self.raise_irq(irq)
+        self.update_next_event()
+
+    def interruptible(self):
+        """
+        True if some enabled interrupt can still arrive.
+        """
+        if self.irq_pending & ~self.irq_mask:
+            return True
+        if self.next_event != NEVER:
+            return True
+        return False
+
+    # ---- Bus ----
+
+    def load_word(self, addr):
+        dev = self.devices.get(addr >> 20)
+        if dev is self.ram:
+            off = addr - RAM_BASE
+            if off + 4 > RAM_SIZE:
+                raise SimError('load from {:08x} outside RAM'.format(addr))
+            return struct.unpack_from('<I', self.ram.mem, off)[0]
+        if dev is None:
+            if FLASH_BASE <= addr < FLASH_BASE + FLASH_SIZE:
+                self.stall(self.flash.access(addr, self.now()))
+                return self.flash.read_word(addr)
+            raise SimError('load from unmapped address {:08x}'.format(addr))
+        self.stall(BUS_WAIT)
+        return dev.read(addr & 0xffffc) & 0xffffffff
+
+    def load(self, addr, size, signed):
+        word = self.load_word(addr & ~3)
+        shift = (addr & 3) * 8
+        value = (word >> shift) & ((1 << (8 * size)) - 1)
+        return sext(value, 8 * size) & 0xffffffff if signed else value
+
+    def store(self, addr, size, value):
+        dev = self.devices.get(addr >> 20)
+        if dev is self.ram:
+            off = addr - RAM_BASE
+            if off + size > RAM_SIZE:
+                raise SimError('store to {:08x} outside RAM'.format(addr))
+            self.ram.mem[off:off + size] = (value & 0xffffffff).to_bytes(4, 'little')[:size]
+            if addr & ~3 in self.decoded or (addr & ~3) - 2 in self.decoded:
+                self.decoded.clear()
+            return
+        if dev is None:
+            if FLASH_BASE <= addr < FLASH_BASE + FLASH_SIZE:
+                raise SimError('store to flash at {:08x}'.format(addr))
+            raise SimError('store to unmapped address {:08x}'.format(addr))
+        self.stall(BUS_WAIT)
+        if size != 4:
+            shift = (addr & 3) * 8
+            mask = ((1 << (8 * size)) - 1) << shift
+            try:
+                old = dev.read(addr & 0xffffc)
+            except SimError:
+                old = 0
+            value = (old & ~mask) | ((value << shift) & mask)
+        dev.write(addr & 0xffffc, value & 0xffffffff)
+        if dev is self.timer0 or dev is self.timer1 or dev is self.spi:
+            self.update_next_event()
+
+    def fetch(self, pc):
+        if RAM_BASE <= pc < RAM_BASE + RAM_SIZE:
+            return struct.unpack_from('<I', self.ram.mem, pc - RAM_BASE)[0]
+        if FLASH_BASE <= pc < FLASH_BASE + FLASH_SIZE:
+            return struct.unpack_from('<I', self.flash.mem, pc - FLASH_BASE)[0]
+        raise SimError('instruction fetch from {:08x}'.format(pc))
+
+    # ---- Decode ----
+
+    def decode(self, pc):
+        if pc & 1:
+            raise SimError('misaligned pc {:08x}'.format(pc))
+        ins = self.fetch(pc)
+        size = 4
+        if ins & 3 != 3:
+            ins = expand_compressed(ins & 0xffff)
+            if ins is None:
+                raise SimError('illegal compressed instruction {:04x} at {:08x}'.format(
+                    self.fetch(pc) & 0xffff, pc))
+            size = 2
+        opcode = ins & 0x7f
+        rd = (ins >> 7) & 0x1f
+        f3 = (ins >> 12) & 7
+        rs1 = (ins >> 15) & 0x1f
+        rs2 = (ins >> 20) & 0x1f
+        f7 = ins >> 25
+        imm_i = sext(ins >> 20, 12)
+        flash = FLASH_BASE <= pc < FLASH_BASE + FLASH_SIZE
+
+        if opcode == 0x37:
+            d = ('lui', rd, 0, 0, ins & 0xfffff000)
+        elif opcode == 0x17:
+            d = ('auipc', rd, 0, 0, (pc + (ins & 0xfffff000)) & 0xffffffff)
+        elif opcode == 0x6f:
+            imm = ((ins >> 31) << 20 | ((ins >> 12) & 0xff) << 12 |
+                   ((ins >> 20) & 1) << 11 | ((ins >> 21) & 0x3ff) << 1)
+            d = ('jal', rd, 0, 0, (pc + sext(imm, 21)) & 0xffffffff)
+        elif opcode == 0x67 and f3 == 0:
+            d = ('jalr', rd, rs1, 0, imm_i)
+        elif opcode == 0x63 and f3 not in (2, 3):
+            imm = ((ins >> 31) << 12 | ((ins >> 7) & 1) << 11 |
+                   ((ins >> 25) & 0x3f) << 5 | ((ins >> 8) & 0xf) << 1)
+            d = (('beq', 'bne', None, None, 'blt', 'bge', 'bltu', 'bgeu')[f3],
+                 0, rs1, rs2, (pc + sext(imm, 13)) & 0xffffffff)
+        elif opcode == 0x03 and f3 in (0, 1, 2, 4, 5):
+            d = ('load', rd, rs1, f3, imm_i)
+        elif opcode == 0x23 and f3 in (0, 1, 2):
+            imm = sext((ins >> 25) << 5 | (ins >> 7) & 0x1f, 12)
+            d = ('store', 0, rs1, rs2, imm, 1 << f3)
+        elif opcode == 0x13:
+            if f3 == 1 and f7 == 0:
+                d = ('slli', rd, rs1, 0, rs2)
+            elif f3 == 5 and f7 in (0, 0x20):
+                d = ('srai' if f7 else 'srli', rd, rs1, 0, rs2)
+            elif f3 in (1, 5):
+                raise SimError('illegal instruction {:08x} at {:08x}'.format(ins, pc))
+            else:
+                d = (('addi', None, 'slti', 'sltiu', 'xori', None, 'ori', 'andi')[f3],
+                     rd, rs1, 0, imm_i)
+        elif opcode == 0x33 and f7 == 1:
+            d = (('mul', 'mulh', 'mulhsu', 'mulhu', 'div', 'divu', 'rem', 'remu')[f3],
+                 rd, rs1, rs2, 0)
+        elif opcode == 0x33 and f7 in (0, 0x20):
+            name = ('add', 'sll', 'slt', 'sltu', 'xor', 'srl', 'or', 'and')[f3]
+            if f7 == 0x20:
+                if f3 == 0:
+                    name = 'sub'
+                elif f3 == 5:
+                    name = 'sra'
+                else:
+                    raise SimError('illegal instruction {:08x} at {:08x}'.format(ins, pc))
+            d = (name, rd, rs1, rs2, 0)
+        elif opcode == 0x0f:
+            d = ('fence', 0, 0, 0, 0)
+        elif opcode == 0x73 and f3 == 2 and rs1 == 0:
+            csr = ins >> 20
+            if csr not in (0xc00, 0xc01, 0xc02, 0xc80, 0xc81, 0xc82):
+                raise SimError('unsupported CSR {:03x} at {:08x}'.format(csr, pc))
+            d = ('csr', rd, 0, 0, csr)
+        elif opcode == 0x73 and ins in (0x00100073, 0x00000073):
+            d = ('ebreak', 0, 0, 0, 0)
+        elif opcode == 0x0b:
+            # picorv32 custom instructions
+            name = {2: 'retirq', 3: 'maskirq', 4: 'waitirq', 5: 'timer'}.get(f7)
+            if name is None:
+                raise SimError('unsupported picorv32 instruction {:08x} at {:08x}'.format(ins, pc))
+            d = (name, rd, rs1, 0, 0)
+        else:
+            raise SimError('illegal instruction {:08x} at {:08x}'.format(ins, pc))
+
+        d = d[:5] + (flash, d[5] if len(d) > 5 else 0, size)
+        self.decoded[pc] = d
+        return d
+
+    # ---- Execute ----
+
+    def step(self):
+        """
+        Execute one instruction (or take one interrupt).  Returns the
+        instruction tuple that ran.
+        """
+        if self.now() >= self.next_event:
+            self.service_events()
+
+        if not self.irq_active and self.irq_pending & ~self.irq_mask:
+            irqs = self.irq_pending & ~self.irq_mask
+            self.irq_pending &= self.irq_mask
+            self.regs[3] = self.pc
+            self.regs[4] = irqs
+            self.irq_active = True
+            self.pc = PROGADDR_IRQ
+            self.cycles += CPI_IRQ_ENTRY
+            return None
+
+        pc = self.pc
+        d = self.decoded.get(pc)
+        if d is None:
+            d = self.decode(pc)
+        if d[5]:
+            self.stall(self.flash.access(pc, self.now(), fetch=True))
+            if pc & 2 and d[7] == 4:
+                self.stall(self.flash.access(pc + 2, self.now(), fetch=True))
+
+        regs = self.regs
+        op, rd, rs1, rs2, imm = d[0], d[1], d[2], d[3], d[4]
+        a = regs[rs1]
+        npc = pc + d[7]
+        cpi = CPI_ALU
+        val = None
+
+        if op == 'addi':
+            val = a + imm
+        elif op == 'lui' or op == 'auipc':
+            val = imm
+        elif op == 'load':
+            addr = (a + imm) & 0xffffffff
+            size = 1 << (rs2 & 3)
+            if addr & (size - 1):
+                raise SimError('misaligned load from {:08x} at {:08x}'.format(addr, pc))
+            val = self.load(addr, size, rs2 < 4)
+            cpi = CPI_LOAD
+        elif op == 'store':
+            addr = (a + imm) & 0xffffffff
+            size = d[6]
+            if addr & (size - 1):
+                raise SimError('misaligned store to {:08x} at {:08x}'.format(addr, pc))
+            self.store(addr, size, regs[rs2])
+            cpi = CPI_STORE
+        elif op[0] == 'b':
+            b = regs[rs2]
+            if op == 'beq':
+                taken = a == b
+            elif op == 'bne':
+                taken = a != b
+            elif op == 'blt':
+                taken = sext(a, 32) < sext(b, 32)
+            elif op == 'bge':
+                taken = sext(a, 32) >= sext(b, 32)
+            elif op == 'bltu':
+                taken = a < b
+            else:
+                taken = a >= b
+            if taken:
+                npc = imm
+                cpi = CPI_BRANCH_TAKEN
+            else:
+                cpi = CPI_BRANCH
+        elif op == 'jal':
+            val = npc
+            npc = imm
+            cpi = CPI_JAL
+        elif op == 'jalr':
+            val = npc
+            npc = (a + imm) & 0xfffffffe
+            cpi = CPI_JALR
+        elif op == 'add':
+            val = a + regs[rs2]
+        elif op == 'sub':
+            val = a - regs[rs2]
+        elif op == 'and' or op == 'andi':
+            val = a & (regs[rs2] if op == 'and' else imm)
+        elif op == 'or' or op == 'ori':
+            val = a | (regs[rs2] if op == 'or' else imm)
+        elif op == 'xor' or op == 'xori':
+            val = a ^ (regs[rs2] if op == 'xor' else imm)
+        elif op == 'slt' or op == 'slti':
+            val = int(sext(a, 32) < sext(regs[rs2] if op == 'slt' else imm, 32))
+        elif op == 'sltu' or op == 'sltiu':
+            val = int(a < ((regs[rs2] if op == 'sltu' else imm) & 0xffffffff))
+        elif op in ('sll', 'slli'):
+            val = a << ((regs[rs2] if op == 'sll' else imm) & 31)
+            cpi = CPI_SHIFT
+        elif op in ('srl', 'srli'):
+            val = a >> ((regs[rs2] if op == 'srl' else imm) & 31)
+            cpi = CPI_SHIFT
+        elif op in ('sra', 'srai'):
+            val = sext(a, 32) >> ((regs[rs2] if op == 'sra' else imm) & 31)
+            cpi = CPI_SHIFT
+        elif op in ('mul', 'mulh', 'mulhsu', 'mulhu'):
+            b = regs[rs2]
+            if op == 'mul':
+                val = a * b
+            elif op == 'mulh':
+                val = (sext(a, 32) * sext(b, 32)) >> 32
+            elif op == 'mulhsu':
+                val = (sext(a, 32) * b) >> 32
+            else:
+                val = (a * b) >> 32
+            cpi = CPI_MUL
+        elif op in ('div', 'divu', 'rem', 'remu'):
+            b = regs[rs2]
+            if op in ('divu', 'remu'):
+                q, r = (a // b, a % b) if b else (0xffffffff, a)
+            else:
+                sa, sb = sext(a, 32), sext(b, 32)
+                if sb == 0:
+                    q, r = -1, sa
+                elif sa == -0x80000000 and sb == -1:
+                    q, r = sa, 0
+                else:
+                    q = abs(sa) // abs(sb)
+                    q = -q if (sa < 0) != (sb < 0) else q
+                    r = sa - q * sb
+            val = q if op[0] == 'd' else r
+            cpi = CPI_DIV
+        elif op == 'csr':
+            count = {0xc00: self.now(), 0xc01: self.now(), 0xc02: self.instret}.get(
+                imm, {0xc80: self.now(), 0xc81: self.now(), 0xc82: self.instret}.get(imm, 0) >> 32)
+            val = count & 0xffffffff
+        elif op == 'fence':
+            pass
+        elif op == 'retirq':
+            npc = regs[3] & 0xfffffffe
+            self.irq_active = False
+        elif op == 'maskirq':
+            val = self.irq_mask
+            self.irq_mask = a
+        elif op == 'waitirq':
+            if not self.irq_pending:
+                if self.next_event == NEVER:
+                    raise SimError('waitirq at {:08x} with no interrupt source running'.format(pc))
+                self.extra = max(self.extra, self.next_event - self.cycles)
+                self.service_events()
+            if not self.irq_pending:
+                npc = pc
+            val = self.irq_pending
+        elif op == 'timer':
+            now = self.now()
+            val = max(self.irq_timer_at - now, 0) if self.irq_timer_at != NEVER else 0
+            self.irq_timer_at = now + a if a else NEVER
+            self.update_next_event()
+        elif op == 'ebreak':
+            raise SimError('ebreak at {:08x}'.format(pc))
+
+        if val is not None and rd:
+            regs[rd] = val & 0xffffffff
+        self.pc = npc
+        self.cycles += cpi
+        self.instret += 1
+        return d
+
+    def run(self, max_cycles=NEVER, max_insns=NEVER, until=None, profile=None):
+        stop = None
+        while True:
+            if self.now() >= max_cycles:
+                stop = 'max cycles'
+                break
+            if self.instret >= max_insns:
+                stop = 'max instructions'
+                break
+            if until is not None and self.pc == until:
+                stop = 'reached {}'.format(self.symbolize(until))
+                break
+            pc = self.pc
+            before = self.now()
+            d = self.step()
+            if profile is not None:
+                key = self.symbolize(pc).split('+')[0] if d else '<irq>'
+                entry = profile.setdefault(key, [0, 0])
+                entry[0] += 1 if d else 0
+                entry[1] += self.now() - before
+            if d and d[0] == 'jal' and d[4] == pc and not self.interruptible():
+                stop = 'idle loop at {}'.format(self.symbolize(pc))
+                break
+        return stop
+
+
+# ----------------------------------------------------------------------------
+# Command line
+# ----------------------------------------------------------------------------
+
+def printable(data):
+    out = []
+    for c in data:
+        if c == 0x0a or 0x20 <= c < 0x7f:
+            out.append(chr(c))
+        elif c == 0x0d:
+            continue
+        else:
+            out.append('\\x{:02x}'.format(c))
+    return ''.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Caravel management core ISS')
+    parser.add_argument('image', help='firmware .elf or objcopy verilog .hex')
+    parser.add_argument('--max-cycles', type=lambda v: int(v, 0), default=NEVER)
+    parser.add_argument('--max-insns', type=lambda v: int(v, 0), default=NEVER)
+    parser.add_argument('--until', help='stop when the pc reaches this symbol')
+    parser.add_argument('--user-model', choices=sorted(USER_MODELS), default='ram')
+    parser.add_argument('--la-in', type=lambda v: int(v, 0), default=0,
+                        help='128-bit value seen on LA inputs')
+    parser.add_argument('--spi-loopback', action='store_true')
+    parser.add_argument('--profile', action='store_true',
+                        help='report instructions and cycles per function')
+    parser.add_argument('--trace-io', action='store_true',
+                        help='log peripheral writes with cycle stamps')
+    parser.add_argument('--uart', action='store_true',
+                        help='echo UART output while running')
+    parser.add_argument('--json', action='store_true',
+                        help='print the results as JSON')
+    parser.add_argument('--flash-file',
+                        help='flash contents kept across runs (loaded under the image, saved after)')
+    args = parser.parse_args()
+
+    sim = Sim(user_model=args.user_model, la_in=args.la_in,
+              spi_loopback=args.spi_loopback, uart_echo=args.uart,
+              trace_io=args.trace_io)
+    if args.flash_file and os.path.exists(args.flash_file):
+        with open(args.flash_file, 'rb') as f:
+            sim.load_image(FLASH_BASE, f.read(FLASH_SIZE))
+    if args.image.endswith('.hex'):
+        sim.load_hex(args.image)
+    else:
+        sim.load_elf(args.image)
+
+    until = None
+    if args.until:
+        if args.until not in sim.symtab:
+            print('Error: symbol {} not found in {}'.format(args.until, args.image))
+            return 1
+        until = sim.symtab[args.until]
+
+    profile = {} if args.profile else None
+    error = None
+    try:
+        stop = sim.run(args.max_cycles, args.max_insns, until, profile)
+    except SimError as e:
+        stop = 'error'
+        error = str(e)
+    if args.flash_file:
+        with open(args.flash_file, 'wb') as f:
+            f.write(sim.flash.mem)
+
+    result = {
+        'image': os.path.basename(args.image),
+        'stop': stop,
+        'pc': sim.pc,
+        'instructions': sim.instret,
+        'cycles': sim.now(),
+        'cpi': round(sim.now() / sim.instret, 3) if sim.instret else 0,
+        'uart': sim.uart.output.decode('latin-1'),
+        'mprj_xfers': sim.mprj.xfers,
+    }
+    if error:
+        result['error'] = error
+    if profile is not None:
+        result['profile'] = {k: {'instructions': v[0], 'cycles': v[1]}
+                             for k, v in profile.items()}
+    if args.trace_io:
+        result['events'] = [{'cycle': c, 'device': d, 'reg': r, 'value': v}
+                            for c, d, r, v in sim.events]
+
+    if args.json:
+        print(json.dumps(result, indent=2))
+    else:
+        if args.uart and sim.uart.output:
+            print('')
+        print('stop:         {}{}'.format(stop, ' ({})'.format(error) if error else ''))
+        print('pc:           {:08x} {}'.format(sim.pc, sim.symbolize(sim.pc)))
+        print('instructions: {}'.format(sim.instret))
+        print('cycles:       {}'.format(sim.now()))
+        print('cpi:          {}'.format(result['cpi']))
+        print('mprj xfers:   {}'.format(sim.mprj.xfers))
+        print('uart:         {} bytes'.format(len(sim.uart.output)))
+        if sim.uart.output and not args.uart:
+            for line in printable(sim.uart.output).split('\n'):
+                print('  | ' + line)
+        if profile is not None:
+            print('')
+            print('{:<32} {:>12} {:>12}'.format('function', 'instructions', 'cycles'))
+            for name, (n, c) in sorted(profile.items(), key=lambda x: -x[1][1]):
+                print('{:<32} {:>12} {:>12}'.format(name, n, c))
+        if args.trace_io:
+            print('')
+            for c, d, r, v in sim.events:
+                print('{:>12}  {:<8} {:<6} {:08x}'.format(c, d, r, v))
+
+    return 1 if error else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+#
+# elf32.py --- Minimal little-endian ELF32 reader for the Caravel firmware tools.
+#
+# Only what the host-side tools need: section headers, program headers
+# (loadable segments) and the symbol table.  No external dependencies.
+#
+
+import struct
+
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+
+PT_LOAD = 1
+
+STT_NOTYPE = 0
+STT_OBJECT = 1
+STT_FUNC = 2
+STT_SECTION = 3
+STT_FILE = 4
+
+STB_LOCAL = 0
+
+
+class Section:
+    def __init__(self, name, type, flags, addr, offset, size, link, entsize):
+        self.name = name
+        self.type = type
+        self.flags = flags
+        self.addr = addr
+        self.offset = offset
+        self.size = size
+        self.link = link
+        self.entsize = entsize
+        self.lma = addr
+
+
+class Segment:
+    def __init__(self, type, offset, vaddr, paddr, filesz, memsz, flags):
+        self.type = type
+        self.offset = offset
+        self.vaddr = vaddr
+        self.paddr = paddr
+        self.filesz = filesz
+        self.memsz = memsz
+        self.flags = flags
+
+
+class Symbol:
+    def __init__(self, name, value, size, type, bind, shndx):
+        self.name = name
+        self.value = value
+        self.size = size
+        self.type = type
+        self.bind = bind
+        self.shndx = shndx
+
+
+class Elf32:
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError('{}: not an ELF file'.format(path))
+        if self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError('{}: not a little-endian ELF32 file'.format(path))
+
+        (self.type, self.machine, _, self.entry, phoff, shoff, _, _,
+         phentsize, phnum, shentsize, shnum, shstrndx) = \
+            struct.unpack_from('<HHIIIIIHHHHHH', self.data, 16)
+
+        self.segments = []
+        for i in range(phnum):
+            fields = struct.unpack_from('<IIIIIIII', self.data, phoff + i * phentsize)
+            self.segments.append(Segment(fields[0], fields[1], fields[2], fields[3],
+                                         fields[4], fields[5], fields[6]))
+
+        raw = []
+        for i in range(shnum):
+            raw.append(struct.unpack_from('<IIIIIIIIII', self.data, shoff + i * shentsize))
+
+        strtab = raw[shstrndx] if shnum else None
+        self.sections = []
+        for (name, type, flags, addr, offset, size, link, _, _, entsize) in raw:
+            sname = self._str(strtab[4], name) if strtab else ''
+            self.sections.append(Section(sname, type, flags, addr, offset, size, link, entsize))
+
+        # Load address of each allocated section (differs from the run
+        # address for .data, which is copied out of flash by start.s).
+        for s in self.sections:
+            if not (s.flags & SHF_ALLOC):
+                continue
+            for p in self.segments:
+                if p.type == PT_LOAD and p.vaddr <= s.addr < p.vaddr + max(p.memsz, 1):
+                    s.lma = p.paddr + (s.addr - p.vaddr)
+                    break
+
+        self.symbols = []
+        for s in self.sections:
+            if s.type != SHT_SYMTAB:
+                continue
+            names = self.sections[s.link]
+            for off in range(s.offset, s.offset + s.size, 16):
+                name, value, size, info, _, shndx = struct.unpack_from('<IIIBBH', self.data, off)
+                self.symbols.append(Symbol(self._str(names.offset, name), value, size,
+                                           info & 0xf, info >> 4, shndx))
+
+    def _str(self, base, off):
+        end = self.data.index(b'\0', base + off)
+        return self.data[base + off:end].decode('ascii', 'replace')
+
+    def section(self, name):
+        for s in self.sections:
+            if s.name == name:
+                return s
+        return None
+
+    def section_data(self, s):
+        if s.type == SHT_NOBITS:
+            return bytes(s.size)
+        return self.data[s.offset:s.offset + s.size]
+
+    def segment_data(self, p):
+        return self.data[p.offset:p.offset + p.filesz]
+
+    def symbol(self, name):
+        for s in self.symbols:
+            if s.name == name:
+                return s
+        return None
+
+    def functions(self):
+        """
+        Code symbols sorted by address, with sizes filled in from the
+        distance to the next symbol when the assembler left them at zero.
+        """
+        code = set(i for i, s in enumerate(self.sections) if s.flags & SHF_EXECINSTR)
+        syms = [s for s in self.symbols
+                if s.shndx in code and s.name and not s.name.startswith('.L')
+                and s.type in (STT_FUNC, STT_NOTYPE)]
+        syms.sort(key=lambda s: (s.value, s.type != STT_FUNC))
+
+        result = []
+        seen = set()
+        for i, s in enumerate(syms):
+            if s.value in seen:
+                continue
+            seen.add(s.value)
+            size = s.size
+            if size == 0:
+                sec = self.sections[s.shndx]
+                end = sec.addr + sec.size
+                for t in syms[i + 1:]:
+                    if t.value > s.value:
+                        end = min(end, t.value)
+                        break
+                size = end - s.value
+            result.append((s.name, s.value, size))
+        return result
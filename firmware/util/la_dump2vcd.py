@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#
+# la_dump2vcd.py --- Convert logic analyzer capture dumps (la_capture_io.c) to VCD.
+#
+# Usage:  la_dump2vcd.py [options] [<uart.log>]
+#
+# Reads a UART log (a file, or stdin) holding the output of
+# la_capture_dump(), possibly mixed with other text or prefixed as in the
+# "make sim" output, and writes one VCD file per capture found.  Each
+# sampled LA word becomes a 32-bit vector la<i> (LA bits 32*i+31..32*i);
+# bits named with --name become scalar signals as well.  A "trigger" signal
+# is high for the trigger sample.
+#
+# Sample times come from the capture's loop cycles and samples taken,
+# with --clock-hz the core clock.
+#
+# Example:
+#
+#   la_dump2vcd.py --name 0=ctl_pipeline_en --name 118=wake -o la.vcd uart.log
+#
+
+import argparse
+import re
+import sys
+
+HEADER = re.compile(r'la capture words ([0-9a-f]+) samples (\d+) trigger (\d+) '
+                    r'taken (\d+) cycles (\d+)')
+RUN = re.compile(r'la (\d+)((?: [0-9a-f]{8})+)\s*$')
+END = re.compile(r'la end')
+
+
+def parse(lines):
+    """
+    Return the captures in lines:  dicts with words (LA word numbers),
+    samples, trigger, taken, cycles and runs ([count, [word values]]).
+    """
+    captures = []
+    cap = None
+    for line in lines:
+        m = HEADER.search(line)
+        if m:
+            words = int(m.group(1), 16)
+            cap = {'words': [i for i in range(4) if words & (1 << i)],
+                   'samples': int(m.group(2)), 'trigger': int(m.group(3)),
+                   'taken': int(m.group(4)), 'cycles': int(m.group(5)), 'runs': []}
+            continue
+        if cap is None:
+            continue
+        if END.search(line):
+            captures.append(cap)
+            cap = None
+            continue
+        m = RUN.search(line)
+        if m:
+            values = [int(v, 16) for v in m.group(2).split()]
+            if len(values) != len(cap['words']):
+                raise ValueError('run with {} words in a capture of {}'.format(
+                    len(values), len(cap['words'])))
+            cap['runs'].append([int(m.group(1)), values])
+    if cap is not None:
+        raise ValueError('capture without "la end" (log cut short?)')
+    return captures
+
+
+def vcd_id(n):
+    chars = ''
+    n += 1
+    while n:
+        n, r = divmod(n - 1, 94)
+        chars += chr(33 + r)
+    return chars
+
+
+def write_vcd(f, cap, names, clock_hz):
+    period_ps = cap['cycles'] * 1e12 / clock_hz / max(cap['taken'], 1)
+    count = sum(run[0] for run in cap['runs'])
+    if count != cap['samples']:
+        raise ValueError('runs hold {} samples, header says {}'.format(count, cap['samples']))
+
+    signals = []        # (id, name, width, function of the sample words)
+    for k, word in enumerate(cap['words']):
+        signals.append((vcd_id(len(signals)), 'la{}'.format(word), 32,
+                        lambda values, k=k: values[k]))
+    for bit, name in sorted(names.items()):
+        if bit >> 5 in cap['words']:
+            k = cap['words'].index(bit >> 5)
+            signals.append((vcd_id(len(signals)), name, 1,
+                            lambda values, k=k, b=bit & 31: (values[k] >> b) & 1))
+    trig_id = vcd_id(len(signals))
+
+    f.write('$comment la_capture_io dump:  {} samples, {:.1f} ns per sample $end\n'.format(
+        cap['samples'], period_ps / 1000))
+    f.write('$timescale 1ps $end\n$scope module la $end\n')
+    for ident, name, width, _ in signals:
+        f.write('$var wire {} {} {} $end\n'.format(width, ident, name))
+    f.write('$var wire 1 {} trigger $end\n'.format(trig_id))
+    f.write('$upscope $end\n$enddefinitions $end\n')
+
+    def value(ident, width, v):
+        if width == 1:
+            return '{}{}\n'.format(v, ident)
+        return 'b{:b} {}\n'.format(v, ident)
+
+    last = {}
+    sample = 0
+    trigger = cap['trigger']
+    for n, values in cap['runs']:
+        # split the run at the trigger sample so the marker sits on it
+        points = sorted({sample, trigger, trigger + 1} & set(range(sample, sample + n)))
+        for p in points:
+            out = []
+            for ident, name, width, get in signals:
+                v = get(values)
+                if last.get(ident) != v:
+                    out.append(value(ident, width, v))
+                    last[ident] = v
+            t = 1 if p == trigger else 0
+            if last.get(trig_id) != t:
+                out.append(value(trig_id, 1, t))
+                last[trig_id] = t
+            if out:
+                f.write('#{}\n'.format(int(round(p * period_ps))))
+                f.write(''.join(out))
+        sample += n
+    f.write('#{}\n'.format(int(round(sample * period_ps))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='LA capture dump to VCD')
+    parser.add_argument('log', nargs='?', help='UART log (default stdin)')
+    parser.add_argument('-o', '--out', default='la.vcd',
+                        help='VCD file (la-<n>.vcd for the n-th further capture)')
+    parser.add_argument('--clock-hz', type=float, default=10e6, help='core clock')
+    parser.add_argument('--name', action='append', default=[],
+                        help='<bit>=<name>:  also show LA bit as a named signal')
+    args = parser.parse_args()
+
+    names = {}
+    for item in args.name:
+        bit, _, name = item.partition('=')
+        if not bit.isdigit() or not name or int(bit) > 127:
+            parser.error('--name takes <bit>=<name> with bit 0-127')
+        names[int(bit)] = name
+
+    try:
+        if args.log:
+            with open(args.log, errors='replace') as f:
+                captures = parse(f)
+        else:
+            captures = parse(sys.stdin)
+        if not captures:
+            raise ValueError('no capture found')
+        for i, cap in enumerate(captures):
+            path = args.out
+            if i:
+                base, dot, ext = args.out.rpartition('.')
+                path = '{}-{}.{}'.format(base, i, ext) if dot else '{}-{}'.format(args.out, i)
+            with open(path, 'w') as f:
+                write_vcd(f, cap, names, args.clock_hz)
+            print('{}: {} samples of LA word(s) {}'.format(
+                path, cap['samples'], ', '.join(str(w) for w in cap['words'])))
+    except (OSError, ValueError) as e:
+        print('la_dump2vcd.py: ' + str(e), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
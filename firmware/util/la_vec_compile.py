@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+#
+# la_vec_compile.py --- Compile LA test vectors into a vector file for la_vector_io.c.
+#
+# Usage:  la_vec_compile.py [options] <vectors.txt>
+#         la_vec_compile.py [options] --vcd <file.vcd> --step <time> --map <signal>=<bit> ...
+#
+# Text source, one statement per line ('#' starts a comment):
+#
+#   drive 0 1          LA words the vectors write, in this order (default 0)
+#   sample 2 3         LA words sampled at every step (default none)
+#   oe ffffffff 0000ffff
+#                      bits the core drives (1) in each drive word, from
+#                      the next vector on (default all bits)
+#   00000001 00000000  one vector:  a hex value per drive word
+#   00000002 0 * 10    the same, held for 10 steps
+#
+# VCD source:  every --step time units from 0 to the end of the dump, the
+# signals given with --map are sampled and placed on the LA bits they are
+# mapped to (a vector signal with its LSB on the given bit).  Only mapped
+# bits are driven; x and z read as 0.  --sample adds LA words to sample.
+#
+# Equal consecutive vectors are merged into one record with a repeat count.
+# With --asm, the vector file is written as an assembler source defining
+# the symbol given by --symbol in .rodata; with --bin, as a raw binary.
+#
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = 0x3156414c      # "LAV1"
+OE = 0x80000000
+REPEAT_MAX = 0x00ffffff
+
+
+class Source:
+    def __init__(self):
+        self.drive = [0]
+        self.sample = []
+        self.steps = []         # (values, oe or None, repeat)
+
+
+def parse_words(fields, what, lineno):
+    try:
+        words = sorted(set(int(f) for f in fields))
+    except ValueError:
+        words = [-1]
+    if not words or words[0] < 0 or words[-1] > 3:
+        raise ValueError('line {}: {} takes LA word numbers 0-3'.format(lineno, what))
+    return words
+
+
+def parse_text(f):
+    src = Source()
+    oe = None
+    for lineno, line in enumerate(f, 1):
+        fields = line.split('#')[0].split()
+        if not fields:
+            continue
+        if fields[0] == 'drive':
+            if src.steps:
+                raise ValueError('line {}: drive after the first vector'.format(lineno))
+            src.drive = parse_words(fields[1:], 'drive', lineno)
+            continue
+        if fields[0] == 'sample':
+            src.sample = parse_words(fields[1:], 'sample', lineno)
+            continue
+        repeat = 1
+        if '*' in fields:
+            i = fields.index('*')
+            if i != len(fields) - 2:
+                raise ValueError('line {}: "* <repeat>" must end the line'.format(lineno))
+            repeat = int(fields[-1], 0)
+            fields = fields[:i]
+        try:
+            values = [int(v, 16) for v in (fields[1:] if fields[0] == 'oe' else fields)]
+        except ValueError:
+            raise ValueError('line {}: expected hex values'.format(lineno))
+        if len(values) != len(src.drive) or any(v >> 32 for v in values):
+            raise ValueError('line {}: expected {} 32-bit hex value(s)'.format(
+                lineno, len(src.drive)))
+        if fields[0] == 'oe':
+            oe = values
+            continue
+        if repeat < 1:
+            raise ValueError('line {}: repeat must be at least 1'.format(lineno))
+        src.steps.append((values, oe, repeat))
+        oe = None
+    return src
+
+
+def parse_vcd(f, maps, step):
+    """
+    Sample the mapped signals of a VCD every step time units.
+    """
+    ids = {}
+    found = set()
+    scope = []
+    changes = []
+    t = 0
+    tokens = f.read().split()
+    i = 0
+    while i < len(tokens):
+        tok = tokens[i]
+        if tok == '$scope':
+            scope.append(tokens[i + 2])
+            i += 4
+        elif tok == '$upscope':
+            scope.pop()
+            i += 2
+        elif tok == '$var':
+            width, ident, name = int(tokens[i + 2]), tokens[i + 3], tokens[i + 4]
+            for key in (name, '.'.join(scope + [name])):
+                if key in maps and key not in found:
+                    ids.setdefault(ident, []).append((maps[key], width))
+                    found.add(key)
+            i = tokens.index('$end', i) + 1
+        elif tok in ('$dumpvars', '$dumpall', '$dumpon', '$dumpoff', '$end'):
+            i += 1
+        elif tok.startswith('$'):
+            i = tokens.index('$end', i) + 1
+        elif tok.startswith('#'):
+            t = int(tok[1:])
+            i += 1
+        elif tok[0] in 'bBrR':
+            value, ident = tok[1:], tokens[i + 1]
+            if ident in ids:
+                v = int(re.sub('[xXzZ]', '0', value), 2) if tok[0] in 'bB' else 0
+                changes.append((t, ident, v))
+            i += 2
+        elif tok[0] in '01xXzZ':
+            ident = tok[1:]
+            if ident in ids:
+                changes.append((t, ident, 1 if tok[0] == '1' else 0))
+            i += 1
+        else:
+            i += 1
+
+    missing = set(maps) - found
+    if missing:
+        raise ValueError('signal(s) not in the VCD: ' + ', '.join(sorted(missing)))
+
+    src = Source()
+    mask = 0
+    for v in ids.values():
+        for bit, width in v:
+            mask |= ((1 << width) - 1) << bit
+    src.drive = [w for w in range(4) if (mask >> (32 * w)) & 0xffffffff]
+    oe = [(mask >> (32 * w)) & 0xffffffff for w in src.drive]
+
+    state = {ident: 0 for ident in ids}
+    end = changes[-1][0] if changes else 0
+    c = 0
+    for when in range(0, end + 1, step):
+        while c < len(changes) and changes[c][0] <= when:
+            state[changes[c][1]] = changes[c][2]
+            c += 1
+        word = 0
+        for ident, v in state.items():
+            for bit, width in ids[ident]:
+                word |= (v & ((1 << width) - 1)) << bit
+        src.steps.append(([(word >> (32 * w)) & 0xffffffff for w in src.drive],
+                          oe if not src.steps else None, 1))
+    return src
+
+
+def pack(src):
+    if not src.steps:
+        raise ValueError('no vectors')
+    records = []
+    oe_now = None
+    for values, oe, repeat in src.steps:
+        if oe is None and oe_now is None:
+            oe = [0xffffffff] * len(src.drive)
+        if oe == oe_now:
+            oe = None
+        if records and oe is None and records[-1][0] == values and \
+                records[-1][2] + repeat <= REPEAT_MAX:
+            records[-1][2] += repeat
+            continue
+        while repeat > REPEAT_MAX:
+            records.append([values, oe, REPEAT_MAX])
+            repeat -= REPEAT_MAX
+            oe = None
+        records.append([values, oe, repeat])
+        if oe is not None:
+            oe_now = oe
+
+    mask = sum(1 << w for w in src.drive) | sum(0x10 << w for w in src.sample)
+    words = [MAGIC, len(records), mask, sum(r[2] for r in records)]
+    for values, oe, repeat in records:
+        words.append(repeat | (OE if oe is not None else 0))
+        words += values
+        if oe is not None:
+            words += [~v & 0xffffffff for v in oe]
+    return words
+
+
+def write_asm(path, words, symbol, source):
+    with open(path, 'w') as f:
+        f.write('# Generated by la_vec_compile.py from {} -- do not edit\n\n'.format(source))
+        f.write('.section .rodata\n.balign 4\n.global {0}\n{0}:\n'.format(symbol))
+        for i in range(0, len(words), 4):
+            f.write('\t.word ' + ', '.join('0x{:08x}'.format(w) for w in words[i:i + 4]) + '\n')
+        f.write('.size {0}, . - {0}\n'.format(symbol))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='LA vector compiler')
+    parser.add_argument('source', nargs='?', help='text vector source')
+    parser.add_argument('--vcd', help='VCD vector source')
+    parser.add_argument('--step', type=int, help='VCD time units per step')
+    parser.add_argument('--map', action='append', default=[],
+                        help='<signal>=<bit>:  put a VCD signal on an LA bit')
+    parser.add_argument('--sample', type=int, action='append', default=[],
+                        help='LA word to sample at every step (VCD source)')
+    parser.add_argument('--asm', help='write the vector file as an assembler source')
+    parser.add_argument('--bin', help='write the vector file as a raw binary')
+    parser.add_argument('--symbol', default='la_vectors', help='vector file symbol for --asm')
+    args = parser.parse_args()
+
+    if bool(args.source) == bool(args.vcd):
+        parser.error('give either a text source or --vcd')
+
+    try:
+        if args.vcd:
+            if not args.step or not args.map:
+                raise ValueError('--vcd needs --step and --map')
+            maps = {}
+            for item in args.map:
+                name, _, bit = item.rpartition('=')
+                if not name or not bit.isdigit() or int(bit) > 127:
+                    raise ValueError('--map takes <signal>=<bit> with bit 0-127')
+                maps[name] = int(bit)
+            with open(args.vcd) as f:
+                src = parse_vcd(f, maps, args.step)
+            src.sample = sorted(set(args.sample))
+        else:
+            with open(args.source) as f:
+                src = parse_text(f)
+        words = pack(src)
+    except (OSError, ValueError) as e:
+        print('la_vec_compile.py: ' + str(e), file=sys.stderr)
+        return 1
+
+    if args.asm:
+        write_asm(args.asm, words, args.symbol, args.source or args.vcd)
+    if args.bin:
+        with open(args.bin, 'wb') as f:
+            f.write(struct.pack('<{}I'.format(len(words)), *words))
+
+    print('{} records, {} steps, {} bytes'.format(words[1], words[3], len(words) * 4))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,408 @@
+#!/usr/bin/env python3
+#
+# mem_report.py --- RAM/stack footprint and code size report for a Caravel firmware image.
+#
+# Usage:  mem_report.py [options] <file.elf>
+#
+# Reports, for one linked firmware image:
+#   - size of every allocated section, split into FLASH and RAM
+#   - size of every function and data object
+#   - stack frame size of every function (from gcc -fstack-usage .su files,
+#     falling back to the "addi sp,sp,-N" prologue in the disassembly)
+#   - the worst-case call chain from the reset entry point (and from any
+#     interrupt entry given with --irq-root, which is added on top)
+#
+# The management SoC has 1 KB of RAM shared by .data, .bss and the stack.
+# Code placed in RAM with RAMFUNC (ramfunc.h) lives at the start of .data
+# (_sramfunc.._eramfunc) and is reported separately.
+# If .data + .bss + worst-case stack exceeds --ram-size the script exits
+# with an error, which fails the build.
+#
+# With --out, a short key/value summary is written to the given file.  The
+# differences against its previous contents are printed before it is
+# overwritten, so changes in memory use show up from one build to the next.
+#
+# The summary is also checked against the budgets in firmware/mem_budget.txt
+# (--budget), which is under version control:  a RAM figure over budget
+# fails the build, flash over budget only warns.  --accept writes the
+# current figures into the budget file as the limits for this firmware.
+#
+
+import argparse
+import glob
+import os
+import re
+import struct
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import elf32
+
+FLASH_BASE = 0x10000000
+FLASH_SIZE = 0x400000
+RAM_BASE = 0x01000000
+
+FUNC_RE = re.compile(r'^([0-9a-f]+) <([^>]+)>:$')
+ADDR_RE = re.compile(r'^\s*[0-9a-f]+:')
+HEX_RE = re.compile(r'^[0-9a-f ]*$')
+TARGET_RE = re.compile(r'<([^>+]+)>')
+FRAME_RE = re.compile(r'^sp,sp,-(\d+)$')
+
+CALLS = ('jal', 'call', 'c.jal')
+TAILS = ('j', 'tail', 'c.j')
+INDIRECT = ('jalr', 'c.jalr')
+
+
+def read_stack_usage(paths):
+    """
+    Parse gcc -fstack-usage output:  <file>:<line>:<col>:<function> <bytes> <qualifier>
+    """
+    frames = {}
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                fields = line.rstrip('\n').split('\t')
+                if len(fields) < 3:
+                    continue
+                name = fields[0].split(':')[-1]
+                frames[name] = (int(fields[1]), fields[2])
+    return frames
+
+
+def disassemble(objdump, elf_path, entries):
+    """
+    Split the disassembly into functions.  Local labels in assembly sources
+    (loop_init_data, flashio_worker_L1, ...) belong to the function before
+    them; only the names in entries start a new function.
+    """
+    out = subprocess.run([objdump, '-d', elf_path], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+
+    funcs = {}
+    current = None
+    for line in out.splitlines():
+        m = FUNC_RE.match(line)
+        if m:
+            if m.group(2) in entries or current is None:
+                current = m.group(2)
+                funcs[current] = {'frame': None, 'calls': set(), 'indirect': False}
+            continue
+        m = ADDR_RE.match(line)
+        if not m or current is None:
+            continue
+
+        # <addr>: <opcode bytes> \t <mnemonic> \t <operands>
+        fields = line[m.end():].split('\t')
+        while fields and HEX_RE.match(fields[0]):
+            fields.pop(0)
+        if not fields:
+            continue
+        fn = funcs[current]
+        op, args = fields[0].strip(), ' '.join(fields[1:]).strip()
+
+        if fn['frame'] is None and op in ('addi', 'c.addi16sp', 'c.addi'):
+            f = FRAME_RE.match(args.replace(' ', ''))
+            if f:
+                fn['frame'] = int(f.group(1))
+
+        t = TARGET_RE.search(args)
+        if op in CALLS + TAILS and t:
+            if t.group(1) != current and t.group(1) in entries:
+                fn['calls'].add(t.group(1))
+        elif op in INDIRECT:
+            if t:
+                if t.group(1) in entries:
+                    fn['calls'].add(t.group(1))
+            elif not args.startswith('zero'):
+                fn['indirect'] = True
+    return funcs
+
+
+def irq_table_handlers(elf):
+    """
+    Functions whose addresses irq_table[] (irq_io.c) holds in its initial
+    value; irq_vector calls them through a register.  Handlers set with
+    irq_attach() at run time are not known here.
+    """
+    sym = elf.symbol('irq_table')
+    if not sym or not sym.size:
+        return set()
+    for s in elf.sections:
+        if s.type != elf32.SHT_NOBITS and s.addr <= sym.value < s.addr + s.size:
+            data = elf.section_data(s)[sym.value - s.addr:][:sym.size]
+            break
+    else:
+        return set()
+    by_addr = {addr: fn for fn, addr, _ in elf.functions()}
+    words = struct.unpack('<{}I'.format(len(data) >> 2), data[:len(data) & ~3])
+    return {by_addr[w] for w in words if w in by_addr}
+
+
+def worst_chain(funcs, frames, root):
+    """
+    Deepest stack use reachable from root.  Returns (bytes, chain, notes),
+    where notes lists recursion and indirect calls that could not be followed.
+    """
+    memo = {}
+    notes = set()
+
+    def frame(name):
+        if name in frames:
+            return frames[name][0]
+        fn = funcs.get(name)
+        return (fn['frame'] or 0) if fn else 0
+
+    def visit(name, path):
+        if name in memo:
+            return memo[name]
+        if name in path:
+            notes.add('recursion through {}'.format(name))
+            return (0, [])
+        fn = funcs.get(name)
+        best = (0, [])
+        if fn:
+            if fn['indirect']:
+                notes.add('indirect call in {}'.format(name))
+            for callee in sorted(fn['calls']):
+                sub = visit(callee, path | {name})
+                if sub[0] > best[0]:
+                    best = sub
+        result = (frame(name) + best[0], [name] + best[1])
+        memo[name] = result
+        return result
+
+    depth, chain = visit(root, frozenset())
+    return depth, chain, sorted(notes)
+
+
+def read_summary(path):
+    values = {}
+    if not os.path.isfile(path):
+        return values
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            key, _, value = line.partition(' ')
+            values[key] = value.strip()
+    return values
+
+
+BUDGET_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'mem_budget.txt')
+
+# summary keys checked against the budget, and which way
+BUDGET_UPPER = ('flash', 'ramfunc', 'data', 'bss', 'stack', 'ram_used')
+BUDGET_LOWER = ('ram_free',)
+BUDGET_WARN = ('flash',)
+
+
+def read_budget(path, name):
+    """
+    Limits for firmware name:  the "<key> <limit>" defaults, overridden by
+    any "<name>.<key> <limit>" lines.  Returns (limits, own), own telling
+    whether the file has lines of its own for this firmware.
+    """
+    defaults, limits = {}, {}
+    for key, value in read_summary(path).items():
+        pattern, _, k = key.rpartition('.')
+        if not pattern:
+            defaults[k] = int(value, 0)
+        elif pattern == name:
+            limits[k] = int(value, 0)
+    own = bool(limits)
+    defaults.update(limits)
+    return defaults, own
+
+
+def accept_budget(path, name, summary):
+    """
+    Replace the lines of firmware name in the budget file with its current
+    figures, keeping everything else
+    """
+    lines = []
+    if os.path.isfile(path):
+        with open(path) as f:
+            lines = [l for l in f if not l.startswith(name + '.')]
+    while lines and not lines[-1].strip():
+        lines.pop()
+    lines.append('\n')
+    for key, value in summary:
+        if key in BUDGET_UPPER:
+            lines.append('{}.{} {}\n'.format(name, key, value))
+    with open(path, 'w') as f:
+        f.writelines(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Caravel firmware memory report')
+    parser.add_argument('elf')
+    parser.add_argument('--objdump', default='riscv32-unknown-elf-objdump')
+    parser.add_argument('--su', nargs='*', default=None,
+                        help='gcc .su files (default: *.su next to the ELF)')
+    parser.add_argument('--ram-size', type=lambda v: int(v, 0), default=0x400)
+    parser.add_argument('--root', default='start')
+    parser.add_argument('--irq-root', action='append', default=[])
+    parser.add_argument('--out', help='write tracked summary to this file')
+    parser.add_argument('--budget', default=BUDGET_FILE,
+                        help='budget file to check against (default: firmware/mem_budget.txt)')
+    parser.add_argument('--accept', action='store_true',
+                        help='write the current figures as the budget of this firmware')
+    parser.add_argument('-q', '--quiet', action='store_true',
+                        help='only print the totals and the worst-case chain')
+    args = parser.parse_args()
+
+    elf = elf32.Elf32(args.elf)
+    name = os.path.splitext(os.path.basename(args.elf))[0]
+
+    su = args.su
+    if su is None:
+        su = glob.glob(os.path.join(os.path.dirname(os.path.abspath(args.elf)), '*.su'))
+    frames = read_stack_usage(su)
+    entries = set(s.name for s in elf.symbols
+                  if s.type == elf32.STT_FUNC or s.bind != elf32.STB_LOCAL)
+    entries.update([args.root] + args.irq_root)
+    funcs = disassemble(args.objdump, args.elf, entries)
+    handlers = irq_table_handlers(elf)
+    for irq in args.irq_root:
+        if irq in funcs:
+            funcs[irq]['calls'] |= handlers & set(funcs)
+
+    # ---- Sections ----
+
+    def table(*fields):
+        if not args.quiet:
+            print(*fields)
+
+    flash = 0
+    ram = {'data': 0, 'bss': 0}
+    print('{} memory report'.format(name))
+    table('')
+    table('{:<16} {:>10} {:>10} {:>8}  {}'.format('section', 'addr', 'load', 'size', 'region'))
+    for s in elf.sections:
+        if not (s.flags & elf32.SHF_ALLOC) or s.size == 0:
+            continue
+        in_ram = RAM_BASE <= s.addr < RAM_BASE + args.ram_size
+        if FLASH_BASE <= s.lma < FLASH_BASE + FLASH_SIZE and s.type != elf32.SHT_NOBITS:
+            flash += s.size
+        if in_ram:
+            ram['bss' if s.type == elf32.SHT_NOBITS else 'data'] += s.size
+        table('{:<16} {:>10x} {:>10x} {:>8}  {}'.format(
+            s.name, s.addr, s.lma, s.size, 'RAM' if in_ram else 'FLASH'))
+
+    sramfunc, eramfunc = elf.symbol('_sramfunc'), elf.symbol('_eramfunc')
+    ramfunc = eramfunc.value - sramfunc.value if sramfunc and eramfunc else 0
+    ram['data'] -= ramfunc
+
+    # ---- Symbols ----
+
+    objects = [(s.name, s.value, s.size) for s in elf.symbols
+               if s.type == elf32.STT_OBJECT and s.size]
+    table('')
+    table('{:<32} {:>10} {:>8}'.format('symbol', 'addr', 'size'))
+    for sym, addr, size in sorted(elf.functions() + objects, key=lambda x: (-x[2], x[0])):
+        table('{:<32} {:>10x} {:>8}'.format(sym, addr, size))
+
+    # ---- Stack ----
+
+    table('')
+    table('{:<32} {:>8}  {}'.format('function', 'frame', 'calls'))
+    for fn in sorted(funcs):
+        frame = frames[fn][0] if fn in frames else (funcs[fn]['frame'] or 0)
+        kind = frames[fn][1] if fn in frames else 'asm'
+        calls = ' '.join(sorted(funcs[fn]['calls']))
+        if funcs[fn]['indirect']:
+            calls = (calls + ' (indirect)').strip()
+        table('{:<32} {:>8}  {:<8} {}'.format(fn, frame, kind, calls))
+
+    root = args.root if args.root in funcs else None
+    if root is None:
+        print('\nERROR: entry point "{}" not found in disassembly'.format(args.root))
+        return 1
+    stack, chain, notes = worst_chain(funcs, frames, root)
+    irq_stack, irq_chain = 0, []
+    for irq in args.irq_root:
+        if irq in funcs:
+            depth, sub, sub_notes = worst_chain(funcs, frames, irq)
+            if depth > irq_stack:
+                irq_stack, irq_chain = depth, ['<irq>'] + sub
+            notes += sub_notes
+    chain += irq_chain
+
+    print('')
+    print('worst-case stack: {} bytes'.format(stack + irq_stack))
+    print('  ' + ' -> '.join(chain))
+    for note in notes:
+        print('  warning: {} (not included)'.format(note))
+
+    used = ramfunc + ram['data'] + ram['bss'] + stack + irq_stack
+    free = args.ram_size - used
+    print('')
+    print('flash: {} bytes'.format(flash))
+    print('ram:   {}{} data + {} bss + {} stack = {} of {} bytes ({} free)'.format(
+        '{} code + '.format(ramfunc) if ramfunc else '',
+        ram['data'], ram['bss'], stack + irq_stack, used, args.ram_size, free))
+
+    # ---- Tracked summary ----
+
+    summary = [
+        ('flash', flash),
+        ('ramfunc', ramfunc),
+        ('data', ram['data']),
+        ('bss', ram['bss']),
+        ('stack', stack + irq_stack),
+        ('ram_used', used),
+        ('ram_free', free),
+    ]
+    if args.out:
+        old = read_summary(args.out)
+        for key, value in summary:
+            if key in old and old[key] != str(value):
+                delta = value - int(old[key])
+                print('{}: {} -> {} ({:+d})'.format(key, old[key], value, delta))
+        with open(args.out, 'w') as f:
+            f.write('# {} memory summary (generated by util/mem_report.py)\n'.format(name))
+            for key, value in summary:
+                f.write('{} {}\n'.format(key, value))
+            for fn in sorted(frames):
+                f.write('frame.{} {}\n'.format(fn, frames[fn][0]))
+
+    if free < 0:
+        print('\nERROR: {} exceeds the {} byte RAM budget by {} bytes'.format(
+            name, args.ram_size, -free))
+        return 1
+
+    # ---- Budget ----
+
+    if args.accept:
+        accept_budget(args.budget, name, summary)
+        print('budget: {} limits written to {}'.format(name, args.budget))
+        return 0
+    limits, own = read_budget(args.budget, name)
+    if not own and os.path.isfile(args.budget):
+        print('budget: no limits for {} in {} ("make budget" adds them)'.format(
+            name, os.path.basename(args.budget)))
+    over = 0
+    for key, value in summary:
+        if key not in limits:
+            continue
+        if key in BUDGET_UPPER and value > limits[key]:
+            how = '{} bytes over'.format(value - limits[key])
+        elif key in BUDGET_LOWER and value < limits[key]:
+            how = '{} bytes under'.format(limits[key] - value)
+        else:
+            continue
+        print('{}: {} {} is {} its budget of {}'.format(
+            'warning' if key in BUDGET_WARN else 'ERROR', key, value, how, limits[key]))
+        if key not in BUDGET_WARN:
+            over += 1
+    if over:
+        print('\nERROR: {} is over its memory budget; if the growth is intended, update the '
+              'limits in {} ("make budget")'.format(name, os.path.basename(args.budget)))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
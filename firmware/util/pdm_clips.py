@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# pdm_clips.py --- Build a set of PDM test clips for playback from flash.
+#
+# Usage:  pdm_clips.py [options] [--synthetic] [<file.wav>[:<event_ms>] ...]
+#
+# Each clip is a 1-bit PDM stream, made by a second-order sigma-delta
+# modulator from a 16-bit mono WAV file (every sample held for --osr PDM
+# bits) or, with --synthetic, from a built-in set of silence and tone
+# bursts.  event_ms marks the end of the keyword in a WAV clip; clips
+# without it are expected not to wake the design.
+#
+# The clip set is made of little-endian words:
+#
+#   header   magic, clip count
+#   clips    five words per clip:  PDM bits, event bit (0xffffffff for
+#            none), word offset of the bits from the start of the set,
+#            name (8 characters, zero padded)
+#   bits     the PDM bits of each clip, LSB first, zero padded to a word
+#
+# With --asm, the set is written as an assembler source defining the
+# symbol given by --symbol in .rodata, to be linked into the firmware;
+# with --bin, as a raw binary.
+#
+
+import argparse
+import math
+import os
+import struct
+import sys
+import wave
+
+MAGIC = 0x314d4450      # "PDM1"
+NO_EVENT = 0xffffffff
+
+
+def modulate(samples):
+    """
+    Second-order sigma-delta modulation of samples in [-1, 1].
+    """
+    bits = []
+    i1 = i2 = 0.0
+    y = -1.0
+    for x in samples:
+        i1 += x - y
+        i2 += i1 - y
+        y = 1.0 if i2 >= 0 else -1.0
+        bits.append(1 if y > 0 else 0)
+    return bits
+
+
+def silence(n):
+    return [0.0] * n
+
+
+def tone(n, period, amplitude):
+    return [amplitude * math.sin(2 * math.pi * i / period) for i in range(n)]
+
+
+def synthetic():
+    """
+    name, samples (one per PDM bit), event bit or None
+    """
+    return [
+        ('quiet', silence(8192), None),
+        ('word', silence(2048) + tone(3072, 1024, 0.7) + silence(3072), 5120),
+        ('word2', silence(1024) + tone(4096, 512, 0.5) + silence(3072), 5120),
+        ('short', silence(2048) + tone(1024, 1024, 0.7) + silence(5120), None),
+    ]
+
+
+def read_wav(arg, osr):
+    path, _, event_ms = arg.partition(':')
+    with wave.open(path, 'rb') as w:
+        if w.getnchannels() != 1 or w.getsampwidth() != 2:
+            raise ValueError('{}: not 16-bit mono'.format(path))
+        rate = w.getframerate()
+        frames = w.readframes(w.getnframes())
+    pcm = struct.unpack('<{}h'.format(len(frames) // 2), frames)
+    samples = []
+    for v in pcm:
+        samples += [v / 32768.0] * osr
+    event = None
+    if event_ms:
+        event = int(float(event_ms) * rate * osr / 1000)
+        if event >= len(samples):
+            raise ValueError('{}: event after the end of the clip'.format(path))
+    name = os.path.splitext(os.path.basename(path))[0]
+    return name, samples, event
+
+
+def pack(clips):
+    header = [MAGIC, len(clips)]
+    entries = []
+    data = []
+    offset = len(header) + 5 * len(clips)
+    for name, samples, event in clips:
+        bits = modulate(samples)
+        while len(bits) % 32:
+            bits.append(0)
+        words = [sum(bits[i + b] << b for b in range(32)) for i in range(0, len(bits), 32)]
+        label = name.encode()[:8].ljust(8, b'\0')
+        entries += [len(samples), NO_EVENT if event is None else event,
+                    offset + len(data)] + list(struct.unpack('<2I', label))
+        data += words
+    return header + entries + data
+
+
+def write_asm(path, words, symbol):
+    with open(path, 'w') as f:
+        f.write('# Generated by pdm_clips.py -- do not edit\n\n')
+        f.write('.section .rodata\n.balign 4\n.global {0}\n{0}:\n'.format(symbol))
+        for i in range(0, len(words), 4):
+            f.write('\t.word ' + ', '.join('0x{:08x}'.format(w) for w in words[i:i + 4]) + '\n')
+        f.write('.size {0}, . - {0}\n'.format(symbol))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='PDM test clip builder')
+    parser.add_argument('wavs', nargs='*', help='16-bit mono WAV files, with :<event_ms>')
+    parser.add_argument('--synthetic', action='store_true',
+                        help='add the built-in silence and tone clips')
+    parser.add_argument('--osr', type=int, default=64, help='PDM bits per WAV sample')
+    parser.add_argument('--asm', help='write the clip set as an assembler source')
+    parser.add_argument('--bin', help='write the clip set as a raw binary')
+    parser.add_argument('--symbol', default='pdm_clips', help='clip set symbol for --asm')
+    args = parser.parse_args()
+
+    if not args.wavs and not args.synthetic:
+        parser.error('give WAV files and/or --synthetic')
+
+    try:
+        clips = synthetic() if args.synthetic else []
+        clips += [read_wav(arg, args.osr) for arg in args.wavs]
+    except (OSError, ValueError, wave.Error) as e:
+        print('pdm_clips.py: ' + str(e), file=sys.stderr)
+        return 1
+    words = pack(clips)
+
+    if args.asm:
+        write_asm(args.asm, words, args.symbol)
+    if args.bin:
+        with open(args.bin, 'wb') as f:
+            f.write(struct.pack('<{}I'.format(len(words)), *words))
+
+    for name, samples, event in clips:
+        print('{:<8} {:7} bits  event {}'.format(name, len(samples),
+                                                  '-' if event is None else event))
+    print('{} clips, {} bytes'.format(len(clips), len(words) * 4))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
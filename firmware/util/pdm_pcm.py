@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+#
+# pdm_pcm.py --- Check and save the PCM streamed by pdm_io.c (firmware/pdm_pcm).
+#
+# Usage:  pdm_pcm.py [options] [<uart.log>]
+#
+# Reads a UART log (a file, or stdin) holding the output of pdm_pcm:
+# "pcm clip <name> words <n> decimation <d>" (or "pcm block <n> ...")
+# lines, "pcm <hex> ..." sample lines and "pcm end", possibly mixed with
+# other text or prefixed as in the "make sim" output.
+#
+# With --clips, the PDM clip set the firmware decimated (the --bin output
+# of pdm_clips.py) is decimated again here, from the definition of the
+# filter rather than the firmware's bit-parallel form:  a triangular
+# window of 63 PDM bits per 32-bit word (sinc^2), then a triangular
+# window of 2 * R - 1 words decimating by R (CIC of order 2), scaled to
+# 16 bits.  Every sample must match.
+#
+# With --wav, each stream is written as a 16-bit mono WAV file (wav-<n>
+# for the n-th further stream) at --pdm-hz divided by the decimation.
+#
+
+import argparse
+import re
+import struct
+import sys
+import wave
+
+HEADER = re.compile(r'pcm (clip|block) (\S+) .*decimation (\d+)')
+SAMPLES = re.compile(r'pcm((?: [0-9a-f]{4})+)\s*$')
+END = re.compile(r'pcm end')
+
+CLIPS_MAGIC = 0x314d4450
+
+
+def parse(lines):
+    """
+    Return the streams in lines:  dicts with name, decimation and pcm.
+    """
+    streams = []
+    cur = None
+    for line in lines:
+        m = HEADER.search(line)
+        if m:
+            cur = {'name': m.group(2), 'decimation': int(m.group(3)), 'pcm': []}
+            continue
+        if cur is None:
+            continue
+        if END.search(line):
+            streams.append(cur)
+            cur = None
+            continue
+        m = SAMPLES.search(line)
+        if m:
+            for v in m.group(1).split():
+                v = int(v, 16)
+                cur['pcm'].append(v - 0x10000 if v & 0x8000 else v)
+    if cur is not None:
+        raise ValueError('stream without "pcm end" (log cut short?)')
+    return streams
+
+
+def read_clips(path):
+    """
+    name -> list of PDM words, from a pdm_clips.py binary.
+    """
+    with open(path, 'rb') as f:
+        data = f.read()
+    words = struct.unpack('<{}I'.format(len(data) // 4), data)
+    if len(words) < 2 or words[0] != CLIPS_MAGIC:
+        raise ValueError('{}: not a pdm_clips.py clip set'.format(path))
+    clips = {}
+    for c in range(words[1]):
+        bits, _, offset, n0, n1 = words[2 + 5 * c:7 + 5 * c]
+        name = struct.pack('<2I', n0, n1).rstrip(b'\0').decode()
+        clips[name] = list(words[offset:offset + (bits >> 5)])
+    return clips
+
+
+def decimate(words, decimation):
+    """
+    Reference PDM to PCM, as pdm_decimate() from silence.
+    """
+    r = decimation >> 5
+    d2 = r.bit_length() - 1
+    if r << 5 != decimation or 1 << d2 != r or not 1 <= d2 <= 3:
+        raise ValueError('unsupported decimation {}'.format(decimation))
+
+    bits = []
+    for w in words:
+        bits += [(w >> j) & 1 for j in range(32)]
+    stage1 = []
+    for n in range(len(words)):
+        s = sum((31 - j) * bits[32 * n + j] for j in range(32))
+        if n:
+            s += sum((j + 1) * bits[32 * (n - 1) + j] for j in range(32))
+        stage1.append(s)
+
+    window = [min(i + 1, 2 * r - 1 - i) for i in range(2 * r - 1)]
+    pcm = []
+    for k in range(len(words) >> d2):
+        t = r * k + r - 1
+        s = sum(h * stage1[t - i] for i, h in enumerate(window) if t >= i)
+        pcm.append(min((s - (1 << (9 + 2 * d2))) << (6 - 2 * d2), 32767))
+    return pcm
+
+
+def write_wav(path, pcm, rate):
+    with wave.open(path, 'wb') as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(rate)
+        w.writeframes(struct.pack('<{}h'.format(len(pcm)), *pcm))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='pdm_pcm UART stream checker')
+    parser.add_argument('log', nargs='?', help='UART log (default stdin)')
+    parser.add_argument('--clips', help='pdm_clips.py binary to check the clips against')
+    parser.add_argument('--wav', help='write the streams as WAV files')
+    parser.add_argument('--pdm-hz', type=int, default=1024000, help='PDM bit rate for --wav')
+    args = parser.parse_args()
+
+    try:
+        if args.log:
+            with open(args.log, errors='replace') as f:
+                streams = parse(f)
+        else:
+            streams = parse(sys.stdin)
+        if not streams:
+            raise ValueError('no PCM stream found')
+        clips = read_clips(args.clips) if args.clips else {}
+
+        errors = 0
+        for i, s in enumerate(streams):
+            line = '{:<8} {:6} samples'.format(s['name'], len(s['pcm']))
+            if args.clips:
+                if s['name'] not in clips:
+                    raise ValueError('clip {} not in {}'.format(s['name'], args.clips))
+                ref = decimate(clips[s['name']], s['decimation'])
+                bad = sum(1 for a, b in zip(s['pcm'], ref) if a != b) + abs(len(ref) - len(s['pcm']))
+                errors += bad
+                line += '  {} mismatches'.format(bad) if bad else '  ok'
+            if args.wav:
+                path = args.wav
+                if i:
+                    base, dot, ext = args.wav.rpartition('.')
+                    path = '{}-{}.{}'.format(base, i, ext) if dot else '{}-{}'.format(args.wav, i)
+                write_wav(path, s['pcm'], args.pdm_hz // s['decimation'])
+                line += '  ' + path
+            print(line)
+    except (OSError, ValueError, wave.Error) as e:
+        print('pdm_pcm.py: ' + str(e), file=sys.stderr)
+        return 1
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+#
+# profile_matrix.py --- Size, RAM and cycle table of one firmware built under several profiles.
+#
+# Usage:  profile_matrix.py [options] <pattern> <profile> [<profile> ...]
+#
+# For each profile, build/<profile>/<pattern>.elf (made by "make profiles",
+# see firmware.mk) is measured with mem_report.py (flash bytes, RAM used
+# and left, worst-case stack) and run in caravel_iss.py (instructions and
+# cycles until the firmware stops or --max-cycles, plus the cycles spent
+# in each function given with --funcs).  Profiles that failed to build or
+# do not fit in RAM are listed as such, so the fastest image that still
+# fits can be picked from one table.
+#
+# Function cycles are the cycles spent in the function itself (as in
+# "make sim"); a function inlined by the optimizer shows as "-".
+#
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import sys
+
+UTIL = os.path.dirname(os.path.abspath(__file__))
+
+
+def mem_summary(elf, objdump):
+    """
+    Run mem_report.py and return its key/value summary (or None).
+    """
+    out = elf[:-4] + '.mem'
+    subprocess.run([sys.executable, os.path.join(UTIL, 'mem_report.py'), '-q',
+                    '--irq-root', 'irq_vector', '--objdump', objdump, '--out', out, elf],
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    if not os.path.exists(out):
+        return None
+    summary = {}
+    with open(out) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 2 and not line.startswith('#'):
+                summary[fields[0]] = int(fields[1])
+    return summary
+
+
+def simulate(elf, max_cycles, sim_flags):
+    cmd = [sys.executable, os.path.join(UTIL, 'caravel_iss.py'), '--json', '--profile',
+           '--max-cycles', str(max_cycles)] + sim_flags + [elf]
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    try:
+        return json.loads(result.stdout)
+    except ValueError:
+        return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Firmware build profile matrix')
+    parser.add_argument('pattern')
+    parser.add_argument('profiles', nargs='+')
+    parser.add_argument('--build', default='build', help='profile build directory')
+    parser.add_argument('--objdump', default='riscv32-unknown-elf-objdump')
+    parser.add_argument('--max-cycles', type=lambda v: int(v, 0), default=50000000)
+    parser.add_argument('--sim-flags', default='', help='extra caravel_iss.py options')
+    parser.add_argument('--funcs', default='', help='functions to list cycles for')
+    parser.add_argument('--out', help='also write the table to this file')
+    args = parser.parse_args()
+
+    funcs = args.funcs.split()
+    sim_flags = shlex.split(args.sim_flags)
+
+    header = '{:<12} {:>7} {:>5} {:>5} {:>5} {:>10} {:>11}  {:<12}'.format(
+        'profile', 'flash', 'ram', 'free', 'stack', 'insns', 'cycles', 'stop')
+    header += ''.join(' {:>12}'.format(fn[:12]) for fn in funcs)
+    lines = [args.pattern, '', header]
+
+    for profile in args.profiles:
+        elf = os.path.join(args.build, profile, args.pattern + '.elf')
+        if not os.path.exists(elf):
+            lines.append('{:<12} build failed'.format(profile))
+            continue
+        mem = mem_summary(elf, args.objdump)
+        if mem is None:
+            lines.append('{:<12} mem_report failed'.format(profile))
+            continue
+        row = '{:<12} {:>7} {:>5} {:>5} {:>5}'.format(
+            profile, mem['flash'], mem['ram_used'], mem['ram_free'], mem['stack'])
+        if mem['ram_free'] < 0:
+            lines.append(row + '  does not fit in RAM')
+            continue
+
+        run = simulate(elf, args.max_cycles, sim_flags)
+        if run is None:
+            lines.append(row + '  simulation failed')
+            continue
+        stop = 'error' if run.get('error') else run['stop'].split()[0]
+        row += ' {:>10} {:>11}  {:<12}'.format(run['instructions'], run['cycles'], stop)
+        for fn in funcs:
+            entry = run['profile'].get(fn)
+            row += ' {:>12}'.format(entry['cycles'] if entry else '-')
+        lines.append(row)
+
+    text = '\n'.join(lines) + '\n'
+    sys.stdout.write(text)
+    if args.out:
+        with open(args.out, 'w') as f:
+            f.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+#
+# wakey_pack.py --- Pack Wakey Wakey weights, biases and shifts into a flash blob.
+#
+# Usage:  wakey_pack.py [options] (<weights.json> | --test-pattern)
+#
+# The blob is loaded into the Wakey Wakey configuration memory by
+# wakey_load() (wakey/wakey_load.c).  It is made of little-endian words:
+#
+#   header   magic, bank count, payload words, payload checksum
+#   index    one word per bank:  address [15:0], entries [27:16],
+#            data lane mask [31:28]
+#   payload  the entries of each bank in index order, only the data lanes
+#            the bank uses, packed LSB first (4, 2 or 1 entries per word);
+#            the last word of each bank is zero padded
+#
+# The checksum is "sum = rotl(sum, 1) + word" over the payload words;
+# wakey_load() rebuilds the payload from the configuration memory and
+# compares it, so one readback pass checks both the flash and the stores.
+#
+# The weights file is a JSON object keyed by bank name (see BANKS).  Each
+# value is a list with one entry per bank address; an entry is a list of
+# lane values (one per used data lane), or a number for single-lane banks.
+# Values are bytes, signed (-128..127) or unsigned (0..255).  Banks that
+# are not in the file are left out of the blob.  --test-pattern packs an
+# incrementing pattern instead (entry n holds n, n + 1, ... in its lanes).
+#
+# With --asm, the blob is written as an assembler source defining the
+# symbol given by --symbol in .rodata, to be linked into the firmware;
+# with --bin, as a raw binary.
+#
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x31594b57      # "WKY1"
+
+# name, address, entries, data lanes
+BANKS = [
+    ('conv1.weight0', 0x000,   8, 4),
+    ('conv1.weight1', 0x010,   8, 4),
+    ('conv1.weight2', 0x020,   8, 4),
+    ('conv1.bias',    0x030,   8, 4),
+    ('conv1.shift',   0x040,   1, 4),
+    ('conv2.weight0', 0x050,  16, 2),
+    ('conv2.weight1', 0x060,  16, 2),
+    ('conv2.weight2', 0x070,  16, 2),
+    ('conv2.bias',    0x080,  16, 2),
+    ('conv2.shift',   0x090,   1, 2),
+    ('fc.weight0',    0x100, 208, 1),
+    ('fc.weight1',    0x200, 208, 1),
+    ('fc.bias0',      0x300,   1, 1),
+    ('fc.bias1',      0x400,   1, 1),
+]
+
+
+def test_pattern():
+    """
+    Entry idx of each bank holds idx, idx + 1, ... in its lanes.
+    """
+    values = {}
+    for name, addr, count, lanes in BANKS:
+        values[name] = [[idx + lane for lane in range(lanes)] for idx in range(count)]
+    return values
+
+
+def load_weights(path):
+    with open(path) as f:
+        data = json.load(f)
+    names = [bank[0] for bank in BANKS]
+    unknown = [name for name in data if name not in names]
+    if unknown:
+        raise ValueError('unknown bank(s): ' + ', '.join(unknown))
+    return data
+
+
+def bank_bytes(name, entries, count, lanes):
+    if len(entries) != count:
+        raise ValueError('{}: {} entries, expected {}'.format(name, len(entries), count))
+    out = []
+    for idx, entry in enumerate(entries):
+        if isinstance(entry, int):
+            entry = [entry]
+        if len(entry) != lanes:
+            raise ValueError('{}[{}]: {} lane values, expected {}'.format(
+                name, idx, len(entry), lanes))
+        for value in entry:
+            if not -128 <= value <= 255:
+                raise ValueError('{}[{}]: {} does not fit in a byte'.format(name, idx, value))
+            out.append(value & 0xff)
+    while len(out) % 4:
+        out.append(0)
+    return out
+
+
+def checksum(words):
+    total = 0
+    for word in words:
+        total = ((total << 1) | (total >> 31)) & 0xffffffff
+        total = (total + word) & 0xffffffff
+    return total
+
+
+def pack(values):
+    index = []
+    payload = []
+    for name, addr, count, lanes in BANKS:
+        if name not in values:
+            continue
+        data = bank_bytes(name, values[name], count, lanes)
+        index.append(addr | (count << 16) | (((1 << lanes) - 1) << 28))
+        payload += [struct.unpack_from('<I', bytes(data), i)[0] for i in range(0, len(data), 4)]
+    header = [MAGIC, len(index), len(payload), checksum(payload)]
+    return header + index + payload
+
+
+def write_asm(path, words, symbol, source):
+    with open(path, 'w') as f:
+        f.write('# Generated by wakey_pack.py from {} -- do not edit\n\n'.format(source))
+        f.write('.section .rodata\n.balign 4\n.global {0}\n{0}:\n'.format(symbol))
+        for i in range(0, len(words), 4):
+            f.write('\t.word ' + ', '.join('0x{:08x}'.format(w) for w in words[i:i + 4]) + '\n')
+        f.write('.size {0}, . - {0}\n'.format(symbol))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Wakey Wakey weight blob packer')
+    parser.add_argument('weights', nargs='?', help='weights JSON file')
+    parser.add_argument('--test-pattern', action='store_true',
+                        help='pack an incrementing test pattern')
+    parser.add_argument('--asm', help='write the blob as an assembler source')
+    parser.add_argument('--bin', help='write the blob as a raw binary')
+    parser.add_argument('--symbol', default='wakey_weights', help='blob symbol for --asm')
+    args = parser.parse_args()
+
+    if args.test_pattern == bool(args.weights):
+        parser.error('give either a weights file or --test-pattern')
+
+    try:
+        values = test_pattern() if args.test_pattern else load_weights(args.weights)
+        words = pack(values)
+    except (OSError, ValueError) as e:
+        print('wakey_pack.py: ' + str(e), file=sys.stderr)
+        return 1
+
+    if args.asm:
+        write_asm(args.asm, words, args.symbol, args.weights or 'the test pattern')
+    if args.bin:
+        with open(args.bin, 'wb') as f:
+            f.write(struct.pack('<{}I'.format(len(words)), *words))
+
+    banks = words[1]
+    print('{} banks, {} payload words, {} bytes, checksum {:08x}'.format(
+        banks, words[2], len(words) * 4, words[3]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,17 +1,27 @@
 #include "../defs_mpw-two-mfix.h"
 #include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../gpio_config_io.h"
+#include "../lcd_io.h"
+#include "../power_io.h"
+#include "wakey_load.h"
+#include "wakey_bist.h"
 
 
 // ============================================================================
 // WAKEY WAKEY DEFINITIONS
 // ============================================================================
-// Define Wishbone Addresses in CFG
-#define cfg_reg_addr   (*(volatile uint32_t*)0x30000000)
-#define cfg_reg_ctrl   (*(volatile uint32_t*)0x30000004)
-#define cfg_reg_data_0 (*(volatile uint32_t*)0x30000008)
-#define cfg_reg_data_1 (*(volatile uint32_t*)0x3000000C)
-#define cfg_reg_data_2 (*(volatile uint32_t*)0x30000010)
-#define cfg_reg_data_3 (*(volatile uint32_t*)0x30000014)
+// Pad configuration:  management outputs except the user outputs on 1-4
+// and the UART TX on 6
+static const gpio_config_t wakey_pads[] = {
+    GPIO_PADS(5, 37, GPIO_MODE_MGMT_STD_OUTPUT),
+    GPIO_PADS(1, 4, GPIO_MODE_USER_STD_OUTPUT),
+    GPIO_PAD(6, 0x7ff),
+};
+
+// Self-test results (fail bitmap and per-test cycles)
+static wakey_bist_t bist;
 // ============================================================================
 
 
@@ -57,7 +67,7 @@ void cfg_store(int addr, int data_3, int data_2, int data_1, int data_0)
     cfg_reg_data_3 = data_3;
 
     // write store command - 0x1
-    cfg_reg_ctrl = 0x1;
+    cfg_reg_ctrl = CFG_CTRL_STORE;
 }
 
 
@@ -76,7 +86,7 @@ void cfg_load(int addr, int *data)
     cfg_reg_addr = addr;
 
     // write the load command - 0x2
-    cfg_reg_ctrl = 0x2;
+    cfg_reg_ctrl = CFG_CTRL_LOAD;
 
     // INFO: Currently need to wait one clock cycle before read starts
     __asm__("nop\n\t");
@@ -90,181 +100,6 @@ void cfg_load(int addr, int *data)
 // ============================================================================
 
 
-// ============================================================================
-// MEMORY TEST METHODS
-// ============================================================================
-/*
- * check_output()
- * ----------------------------------------------------------------------------
- * check if 2 int arrays of length 4 contain the same values
- */
-bool check_output(int *expected, int *observed, int len) {
-    for (int k = 0; k < len; k++) {
-        if (expected[k] != observed[k]) {
-            print("\n");
-            print("EXP: ");
-            for (int i = 0; i < len; i++) {
-                print_hex(expected[i], 1);
-                print(" ");
-            }
-            print("\n");
-            print("OBS: ");
-            for (int i = 0; i < len; i++) {
-                print_hex(observed[i], 1);
-                print(" ");
-            }
-            print("\n");
-            return false;
-        }
-    }
-    return true;
-}
-
-
-/*
- * test_conv1_mem()
- * ----------------------------------------------------------------------------
- * test conv1 addresses via write and readback of sequential values
- */
-bool test_conv1_mem()
-{
-    int readbuf[4]  = {0, 0, 0, 0};
-
-    // sequential writes
-    // iterate and write through 4 conv1_mem banks: 3 weights, 1 bias
-    for (int bank = 0x00; bank < 0x40; bank += 0x10) {
-        // each conv1_mem bank has 8 values
-        for (int idx = 0x0; idx < 0x8; idx++) {
-            cfg_store(bank + idx, idx + 3, idx + 2, idx + 1, idx);
-        }
-    }
-
-    // write to conv1_mem shift value
-    int idx = 0;
-    cfg_store(0x40, idx + 3, idx + 2, idx + 1, idx);
-
-    // sequential read
-    for (int bank = 0x00; bank < 0x40; bank += 0x10) {
-        for (int idx = 0x0; idx < 0x8; idx++) {
-            cfg_load(bank + idx, readbuf);
-            int expected[4] = {idx, idx + 1, idx + 2, idx + 3};
-            // conv1 data needs to check all 4 bytes
-            if (!check_output(expected, readbuf, 4)) {
-                return false;
-            }
-        }
-    }
-
-    // read from conv1_mem shift value
-    cfg_load(0x40, readbuf);
-    int expected[4] = {idx, idx + 1, idx + 2, idx + 3};
-    if (!check_output(expected, readbuf, 4)) {
-        return false;
-    }
-
-    return true;
-}
-
-
-/*
- * test_conv2_mem()
- * ----------------------------------------------------------------------------
- * test conv2 addresses via write and readback of sequential values
- */
-bool test_conv2_mem()
-{
-    int readbuf[4]  = {0, 0, 0, 0};
-
-    // sequential writes
-    // iterate and write through 4 conv2_mem banks: 3 weights, 1 bias
-    for (int bank = 0x50; bank < 0x90; bank += 0x10) {
-        // each conv2_mem bank has 16 values
-        for (int idx = 0x00; idx < 0x10; idx++) {
-            cfg_store(bank + idx, idx + 3, idx + 2, idx + 1, idx);
-        }
-    }
-
-    // write to conv2_mem shift value
-    int idx = 0;
-    cfg_store(0x90, idx + 3, idx + 2, idx + 1, idx);
-
-    // sequential read
-    for (int bank = 0x50; bank < 0x90; bank += 0x10) {
-        for (int idx = 0x00; idx < 0x10; idx++) {
-            cfg_load(bank + idx, readbuf);
-            int expected[4] = {idx, idx + 1, idx + 2, idx + 3};
-            // conv2 data needs to check only first 2 bytes
-            if (!check_output(expected, readbuf, 2)) {
-                return false;
-            }
-        }
-    }
-
-    // read from conv2_mem shift value
-    cfg_load(0x90, readbuf);
-    int expected[4] = {idx, idx + 1, idx + 2, idx + 3};
-    if (!check_output(expected, readbuf, 2)) {
-        return false;
-    }
-
-    return true;
-}
-
-
-/*
- * test_fc_mem()
- * ----------------------------------------------------------------------------
- * test fc_mem addresses via write and readback of sequential values
- */
-bool test_fc_mem()
-{
-    int readbuf[4]  = {0, 0, 0, 0};
-
-    // sequential writes
-    // iterate and write through fc_mem weight 0 (0x100) and weight 1 (0x200)
-    for (int bank = 0x100; bank < 0x300; bank += 0x100) {
-        // each fc_mem weight bank has 208 values
-        for (int idx = 0x00; idx < 0xD0; idx++) {
-            // fc_mem banks start at 0x50
-            cfg_store(bank + idx, idx + 3, idx + 2, idx + 1, idx);
-        }
-    }
-
-    int idx = 0;
-    cfg_store(0x300, idx + 3, idx + 2, idx + 1, idx + 0);  // bias 0
-    cfg_store(0x400, idx + 3, idx + 2, idx + 1, idx + 0);  // bias 1
-
-    // sequential read
-    for (int bank = 0x100; bank < 0x300; bank += 0x100) {
-        for (int idx = 0x00; idx < 0xD0; idx++) {
-            cfg_load(bank + idx, readbuf);
-            int expected[4] = {idx, idx + 1, idx + 2, idx + 3};
-            // fc data needs to check only first 1 byte
-            if (!check_output(expected, readbuf, 1)) {
-                return false;
-            }
-        }
-    }
-
-    // read from fc_mem bias 0 value
-    idx = 0;
-    cfg_load(0x300, readbuf);
-    int expected[4] = {idx, idx + 1, idx + 2, idx + 3};
-    if (!check_output(expected, readbuf, 1)) {
-        return false;
-    }
-
-    // read from fc_mem bias 1 value
-    cfg_load(0x400, readbuf);
-    if (!check_output(expected, readbuf, 1)) {
-        return false;
-    }
-
-    return true;
-}
-// ============================================================================
-
-
 // ============================================================================
 // LOGIC ANALYZER TEST METHODS
 // ============================================================================
@@ -307,8 +142,9 @@ void la_test() {
  *  2. Configure PDM Data Input Pin IO_IN[36]
  *  3. Configure PDM Clock Output Pin IO_OUT[35]
  *  4. Configure PDM Activate Input Pin IO_IN[34]
- *  5. Write CFG Data via wishbone
- *  6. Read and Verify CFG Data via wishbone
+ *  5. Self-test the CFG memories via wishbone (wakey_bist.c)
+ *  6. Report the failing banks, if any
+ *  7. Load the weight blob from flash and verify it
  */
 
 void main()
@@ -325,57 +161,15 @@ void main()
     // 4. Configure PDM Activate Input Pin IO_IN[34]
     // reg_mprj_io_34 = GPIO_MODE_USER_STD_INPUT_PULLUP;
 
-    reg_mprj_io_37 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_36 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_35 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_34 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_33 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_32 = GPIO_MODE_MGMT_STD_OUTPUT;
-    
-    reg_mprj_io_31 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_30 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_29 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_28 = GPIO_MODE_MGMT_STD_OUTPUT;
-    
-    reg_mprj_io_27 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_26 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_25 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_24 = GPIO_MODE_MGMT_STD_OUTPUT;
-    
-    reg_mprj_io_23 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_22 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_21 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_20 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_19 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_18 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_17 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_16 = GPIO_MODE_MGMT_STD_OUTPUT;
-    
-    reg_mprj_io_15 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_14 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_13 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_12 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_11 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_10 = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_9  = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_8  = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_7  = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_6  = GPIO_MODE_MGMT_STD_OUTPUT;
-    reg_mprj_io_5  = GPIO_MODE_MGMT_STD_OUTPUT;
-    
-    reg_mprj_io_4 = GPIO_MODE_USER_STD_OUTPUT;
-    reg_mprj_io_3 = GPIO_MODE_USER_STD_OUTPUT;
-    reg_mprj_io_2 = GPIO_MODE_USER_STD_OUTPUT;   // 0x0403
-    reg_mprj_io_1 = GPIO_MODE_USER_STD_OUTPUT;  // 0x1803
-
-    reg_mprj_io_6 = 0x7ff;
-
-
     reg_uart_clkdiv = 1042;
     reg_uart_enable = 1;
+    uart_tx_async(1);
+
+    // the user project must be powered before its pads and LA are set up
+    if (power_user_enable(POWER_USER1_VCCD | POWER_USER1_VDDA, 10000) != 0)
+        print("user power not good\n");
 
-    reg_mprj_xfer = 1;
-    while (reg_mprj_xfer == 1);
+    gpio_config(wakey_pads, GPIO_CONFIG_LEN(wakey_pads));
 
 	// Enable GPIO (all output, ena = 0)
     reg_gpio_ena = 0x0;
@@ -401,52 +195,61 @@ void main()
     reg_la3_oenb = reg_la3_iena = 0xFF0FFFFF; // [127:96], enable [117]
 
     // sleep until LCD boots up
-    for (int i = 0; i < 20000; i++);
+    power_sleep_ms(1000);
 
     // clear screen
-    print("|"); putchar(0x2d); 
-
-    // test conv1 mem
-    print("CONV1 MEM: ");
-    if (test_conv1_mem()) {
-        print("PASS");
-    } else {
-        print("FAIL");
-    }
-    print("\n");
-
-    // test conv2 mem
-    print("CONV2 MEM: ");
-    if (test_conv2_mem()) {
-        print("PASS");
-    } else {
-        print("FAIL");
-    }
-    print("\n");
-
-    // test fc mem
-    print("   FC MEM: ");
-    if (test_fc_mem()) {
-        print("PASS");
-    } else {
-        print("FAIL");
+    lcd_init();
+
+    // self-test the configuration memories, report per layer
+    int fails = wakey_bist(&bist, WAKEY_BIST_ALL);
+
+    lcd_print(0, 0, "CONV1 MEM: ");
+    lcd_print(0, 11, wakey_bist_fails(&bist, WAKEY_BANK_CONV1, WAKEY_BANK_CONV2 - 1) ? "FAIL" : "PASS");
+
+    lcd_print(1, 0, "CONV2 MEM: ");
+    lcd_print(1, 11, wakey_bist_fails(&bist, WAKEY_BANK_CONV2, WAKEY_BANK_FC - 1) ? "FAIL" : "PASS");
+
+    lcd_print(2, 0, "   FC MEM: ");
+    lcd_print(2, 11, wakey_bist_fails(&bist, WAKEY_BANK_FC, WAKEY_BANKS - 1) ? "FAIL" : "PASS");
+
+    // load the packed weights (wakey_weights.s) and verify them
+    lcd_print(3, 0, "  WEIGHTS: ");
+    lcd_print(3, 11, wakey_load(wakey_weights) == 0 ? "PASS" : "FAIL");
+    lcd_flush();
+
+    // details of the failing banks (scroll over the LCD, so redraw after)
+    if (fails) {
+        wakey_bist_report(&bist);
+        lcd_redraw();
     }
+    uart_flush();
 
+    uint32_t blinks = 0, duty;
+
+    power_stats_reset();
     while (1) {
+        // blink count and the share of time awake in the corner, only the
+        // changed digits are sent
+        duty = power_duty();
+        lcd_print_dec(0, 16, blinks++, 4);
+        lcd_print_dec(1, 16, frac16_percent(duty) >> 16, 3);
+        lcd_print(1, 19, "%");
+        lcd_refresh();
+
         // toggle LED!
         reg_gpio_data = 0x1;
         reg_mprj_datal = 0xFFFFFFFF;
         reg_mprj_datah = 0xFFFFFFFF;
         reg_mprj_xfer = 1;
         while (reg_mprj_xfer == 1);
-        for (int i = 0; i < 20000; i++);
+        power_sleep_ms(1000);
 
         reg_gpio_data = 0x0;
         reg_mprj_datal = 0x00000000;
         reg_mprj_datah = 0x00000000;
         reg_mprj_xfer = 1;
         while (reg_mprj_xfer == 1);
-        for (int i = 0; i < 20000; i++);
+        power_sleep_ms(1000);
     }
 }
 // ============================================================================
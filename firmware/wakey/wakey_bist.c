@@ -0,0 +1,252 @@
+#include "wakey_bist.h"
+#include "wakey_load.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+
+// The tests only touch the configuration interface and RAM:  a failing
+// read sets the entry's bit in fail_map, ORs the wrong data bits into the
+// bank's fail_bits and counts against the test, so a bad board is screened
+// as fast as a good one.  Every test leaves the banks with test data; load
+// the weights afterwards.
+
+const wakey_bank_t wakey_banks[WAKEY_BANKS] = {
+    {0x000,   8, 4},	// conv1 weight 0
+    {0x010,   8, 4},	// conv1 weight 1
+    {0x020,   8, 4},	// conv1 weight 2
+    {0x030,   8, 4},	// conv1 bias
+    {0x040,   1, 4},	// conv1 shift
+    {0x050,  16, 2},	// conv2 weight 0
+    {0x060,  16, 2},	// conv2 weight 1
+    {0x070,  16, 2},	// conv2 weight 2
+    {0x080,  16, 2},	// conv2 bias
+    {0x090,   1, 2},	// conv2 shift
+    {0x100, 208, 1},	// fc weight 0
+    {0x200, 208, 1},	// fc weight 1
+    {0x300,   1, 1},	// fc bias 0
+    {0x400,   1, 1},	// fc bias 1
+};
+
+static const char *const wakey_bist_names[WAKEY_BIST_TESTS] = {
+    "march", "walk", "addr", "checker",
+};
+
+// Test in progress
+typedef struct {
+    wakey_bist_t *res;
+    int test;		// index of the test (bit in the wakey_bist() mask)
+    int bank;		// index into wakey_banks[]
+    uint32_t addr;	// first address of the bank
+    uint32_t lanes;
+    uint32_t mask;	// data bits of one entry
+    uint32_t base;	// fail_map bit of the bank's first entry
+} bist_run_t;
+
+static void bist_write(bist_run_t *run, uint32_t i, uint32_t v)
+{
+    cfg_reg_addr = run->addr + i;
+    cfg_reg_data_0 = v & 0xff;
+    if (run->lanes > 1)
+        cfg_reg_data_1 = (v >> 8) & 0xff;
+    if (run->lanes > 2) {
+        cfg_reg_data_2 = (v >> 16) & 0xff;
+        cfg_reg_data_3 = v >> 24;
+    }
+    cfg_reg_ctrl = CFG_CTRL_STORE;
+}
+
+/*
+ * bist_check()
+ * ----------------------------------------------------------------------------
+ * read entry i of the bank and record a failure if it does not hold v
+ */
+static void bist_check(bist_run_t *run, uint32_t i, uint32_t v)
+{
+    uint32_t data, n;
+
+    cfg_reg_addr = run->addr + i;
+    cfg_reg_ctrl = CFG_CTRL_LOAD;
+    // the load takes one clock cycle to start (see cfg_load())
+    __asm__ volatile ("nop");
+    data = cfg_reg_data_0 & 0xff;
+    if (run->lanes > 1)
+        data |= (cfg_reg_data_1 & 0xff) << 8;
+    if (run->lanes > 2) {
+        data |= (cfg_reg_data_2 & 0xff) << 16;
+        data |= (cfg_reg_data_3 & 0xff) << 24;
+    }
+
+    data = (data ^ v) & run->mask;
+    if (data) {
+        n = run->base + i;
+        run->res->fail_map[n >> 5] |= 1 << (n & 31);
+        run->res->fail_bits[run->bank] |= data;
+        run->res->test_fails[run->test]++;
+    }
+}
+
+/*
+ * bist_march()
+ * ----------------------------------------------------------------------------
+ * March C-:  up(w0) up(r0,w1) up(r1,w0) down(r0,w1) down(r1,w0) up(r0)
+ */
+static void bist_march(bist_run_t *run, uint32_t n)
+{
+    uint32_t ones = run->mask;
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        bist_write(run, i, 0);
+    for (i = 0; i < n; i++) {
+        bist_check(run, i, 0);
+        bist_write(run, i, ones);
+    }
+    for (i = 0; i < n; i++) {
+        bist_check(run, i, ones);
+        bist_write(run, i, 0);
+    }
+    for (i = n; i-- > 0; ) {
+        bist_check(run, i, 0);
+        bist_write(run, i, ones);
+    }
+    for (i = n; i-- > 0; ) {
+        bist_check(run, i, ones);
+        bist_write(run, i, 0);
+    }
+    for (i = 0; i < n; i++)
+        bist_check(run, i, 0);
+}
+
+/*
+ * bist_walk()
+ * ----------------------------------------------------------------------------
+ * walk a one through zeros and a zero through ones in each entry
+ */
+static void bist_walk(bist_run_t *run, uint32_t n)
+{
+    uint32_t bit, v;
+
+    for (uint32_t i = 0; i < n; i++) {
+        for (bit = 1; bit & run->mask; bit <<= 1) {
+            bist_write(run, i, bit);
+            bist_check(run, i, bit);
+            v = ~bit & run->mask;
+            bist_write(run, i, v);
+            bist_check(run, i, v);
+        }
+    }
+}
+
+/*
+ * bist_fill()
+ * ----------------------------------------------------------------------------
+ * write the whole bank, then read it back:  address-in-address (lanes
+ * hold the low and high address byte and their inverse) or checkerboard
+ * (0x55/0xaa alternating by entry), XORed with inv
+ */
+static void bist_fill(bist_run_t *run, uint32_t n, uint32_t inv)
+{
+    uint32_t i, v;
+
+    for (i = 0; i < n; i++) {
+        if ((1 << run->test) == WAKEY_BIST_ADDR)
+            v = ((run->addr + i) & 0xffff) | (~(run->addr + i) << 16);
+        else
+            v = (i & 1) ? 0xaaaaaaaa : 0x55555555;
+        bist_write(run, i, v ^ inv);
+    }
+    for (i = 0; i < n; i++) {
+        if ((1 << run->test) == WAKEY_BIST_ADDR)
+            v = ((run->addr + i) & 0xffff) | (~(run->addr + i) << 16);
+        else
+            v = (i & 1) ? 0xaaaaaaaa : 0x55555555;
+        bist_check(run, i, v ^ inv);
+    }
+}
+
+/*
+ * wakey_bist()
+ * ----------------------------------------------------------------------------
+ * run the tests in the WAKEY_BIST_* mask over every bank, timing each
+ * test with rdcycle.  Returns the number of failing entries.
+ */
+int wakey_bist(wakey_bist_t *res, uint32_t tests)
+{
+    bist_run_t run;
+    const wakey_bank_t *bank;
+    uint32_t *p = (uint32_t *) res;
+    uint32_t start;
+
+    for (int i = 0; i < sizeof(*res) / sizeof(uint32_t); i++)
+        p[i] = 0;
+
+    run.res = res;
+    for (run.test = 0; run.test < WAKEY_BIST_TESTS; run.test++) {
+        if (!(tests & (1 << run.test)))
+            continue;
+
+        start = time_cycles();
+        run.base = 0;
+        for (run.bank = 0; run.bank < WAKEY_BANKS; run.bank++) {
+            bank = &wakey_banks[run.bank];
+            run.addr = bank->addr;
+            run.lanes = bank->lanes;
+            run.mask = bank->lanes == 4 ? 0xffffffff : (1 << (bank->lanes << 3)) - 1;
+
+            switch (1 << run.test) {
+            case WAKEY_BIST_MARCH:
+                bist_march(&run, bank->count);
+                break;
+            case WAKEY_BIST_WALK:
+                bist_walk(&run, bank->count);
+                break;
+            default:
+                bist_fill(&run, bank->count, 0);
+                bist_fill(&run, bank->count, 0xffffffff);
+                break;
+            }
+            run.base += bank->count;
+        }
+        res->test_cycles[run.test] = time_elapsed(start);
+    }
+
+    return wakey_bist_fails(res, 0, WAKEY_BANKS - 1);
+}
+
+/*
+ * wakey_bist_fails()
+ * ----------------------------------------------------------------------------
+ * number of failing entries in banks first..last
+ */
+int wakey_bist_fails(const wakey_bist_t *res, int first, int last)
+{
+    uint32_t n = 0;
+    int fails = 0;
+
+    for (int b = 0; b <= last; b++) {
+        for (uint32_t i = 0; i < wakey_banks[b].count; i++, n++)
+            if (b >= first && (res->fail_map[n >> 5] & (1 << (n & 31))))
+                fails++;
+    }
+    return fails;
+}
+
+/*
+ * wakey_bist_report()
+ * ----------------------------------------------------------------------------
+ * print the failing reads and cycles of each test that ran, and the
+ * failing entries and data bits of each bank with failures
+ */
+void wakey_bist_report(const wakey_bist_t *res)
+{
+    for (int t = 0; t < WAKEY_BIST_TESTS; t++) {
+        if (res->test_cycles[t])
+            print_fmt("bist %-8s %6u fails %10u cycles\n", wakey_bist_names[t],
+                      res->test_fails[t], res->test_cycles[t]);
+    }
+    for (int b = 0; b < WAKEY_BANKS; b++) {
+        if (res->fail_bits[b])
+            print_fmt("bank %03x  %3u/%3u entries  bits %08x\n", wakey_banks[b].addr,
+                      wakey_bist_fails(res, b, b), wakey_banks[b].count, res->fail_bits[b]);
+    }
+    print_fmt("bist %u failing entries\n", wakey_bist_fails(res, 0, WAKEY_BANKS - 1));
+}
@@ -0,0 +1,50 @@
+#ifndef WAKEY_BIST_H
+#define WAKEY_BIST_H
+
+#include "../defs_mpw-two-mfix.h"
+
+// Built-in self-test of the Wakey Wakey configuration memories.  Each test
+// runs over every bank with the bank's own entry count and data lane width;
+// failures are only recorded while the tests run and are printed at the end
+// by wakey_bist_report().
+
+// Tests (bit mask for wakey_bist())
+#define WAKEY_BIST_MARCH	0x1	// March C- with all-zeros/all-ones data
+#define WAKEY_BIST_WALK		0x2	// walking one and walking zero per entry
+#define WAKEY_BIST_ADDR		0x4	// address-in-address, then inverted
+#define WAKEY_BIST_CHECKER	0x8	// checkerboard, then inverted
+#define WAKEY_BIST_ALL		0xf
+#define WAKEY_BIST_TESTS	4
+
+// Bank layout (wakey_banks[]):  conv1 and conv2 each have three weight
+// banks, a bias bank and a shift entry; fc has two weight banks and two
+// bias entries
+#define WAKEY_BANK_CONV1	0
+#define WAKEY_BANK_CONV2	5
+#define WAKEY_BANK_FC		10
+#define WAKEY_BANKS		14
+#define WAKEY_BANK_ENTRIES	516
+
+typedef struct {
+    uint16_t addr;
+    uint16_t count;
+    uint8_t lanes;		// data lanes used:  1, 2 or 4 from lane 0
+} wakey_bank_t;
+
+extern const wakey_bank_t wakey_banks[WAKEY_BANKS];
+
+typedef struct {
+    // entries that failed any test, one bit each, banks in table order
+    uint32_t fail_map[(WAKEY_BANK_ENTRIES + 31) >> 5];
+    // data bits seen failing in each bank (lane 0 in bits 7:0)
+    uint32_t fail_bits[WAKEY_BANKS];
+    // failing reads and cycles (rdcycle) of each test
+    uint32_t test_fails[WAKEY_BIST_TESTS];
+    uint32_t test_cycles[WAKEY_BIST_TESTS];
+} wakey_bist_t;
+
+int wakey_bist(wakey_bist_t *res, uint32_t tests);
+int wakey_bist_fails(const wakey_bist_t *res, int first, int last);
+void wakey_bist_report(const wakey_bist_t *res);
+
+#endif // WAKEY_BIST_H
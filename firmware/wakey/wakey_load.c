@@ -0,0 +1,193 @@
+#include "wakey_load.h"
+
+// Streams a weight blob from flash into the configuration memory.  Each
+// payload word is read from flash once and split over 1, 2 or 4 entries;
+// only the data lanes the bank uses are written, so a single-lane fc entry
+// costs three wishbone stores (address, lane 0, control) instead of the
+// six of cfg_store().
+
+/*
+ * wakey_lane_shift()
+ * ----------------------------------------------------------------------------
+ * log2 of the number of data lanes in a lane mask, or -1 if the mask is
+ * not one the loader packs (lane 0, lanes 0-1 or all four)
+ */
+static int wakey_lane_shift(uint32_t lanes)
+{
+    switch (lanes) {
+    case 0x1:
+        return 0;
+    case 0x3:
+        return 1;
+    case 0xf:
+        return 2;
+    }
+    return -1;
+}
+
+/*
+ * wakey_check()
+ * ----------------------------------------------------------------------------
+ * check the blob header and index; returns 0 if every bank has a lane
+ * mask the loader packs and the banks add up to the payload size
+ */
+static int wakey_check(const uint32_t *blob)
+{
+    const uint32_t *index = blob + WAKEY_BLOB_HEADER;
+    uint32_t words = 0;
+    int shift;
+
+    if (blob[0] != WAKEY_BLOB_MAGIC)
+        return -1;
+    for (uint32_t i = 0; i < blob[1]; i++) {
+        shift = wakey_lane_shift(WAKEY_BANK_LANES(index[i]));
+        if (shift < 0)
+            return -1;
+        words += ((WAKEY_BANK_COUNT(index[i]) << shift) + 3) >> 2;
+    }
+    return words == blob[2] ? 0 : -1;
+}
+
+/*
+ * wakey_store_bank()
+ * ----------------------------------------------------------------------------
+ * store n entries from the packed payload at src to addr onwards; returns
+ * the payload word after the bank
+ */
+static const uint32_t *wakey_store_bank(uint32_t addr, uint32_t n, uint32_t lanes,
+                                        const uint32_t *src)
+{
+    uint32_t w;
+
+    if (lanes == 0xf) {
+        for (; n; n--) {
+            w = *src++;
+            cfg_reg_addr = addr++;
+            cfg_reg_data_0 = w & 0xff;
+            cfg_reg_data_1 = (w >> 8) & 0xff;
+            cfg_reg_data_2 = (w >> 16) & 0xff;
+            cfg_reg_data_3 = w >> 24;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+        }
+    } else if (lanes == 0x3) {
+        for (; n >= 2; n -= 2) {
+            w = *src++;
+            cfg_reg_addr = addr;
+            cfg_reg_data_0 = w & 0xff;
+            cfg_reg_data_1 = (w >> 8) & 0xff;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+            cfg_reg_addr = addr + 1;
+            cfg_reg_data_0 = (w >> 16) & 0xff;
+            cfg_reg_data_1 = w >> 24;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+            addr += 2;
+        }
+        if (n) {
+            w = *src++;
+            cfg_reg_addr = addr;
+            cfg_reg_data_0 = w & 0xff;
+            cfg_reg_data_1 = (w >> 8) & 0xff;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+        }
+    } else {
+        for (; n >= 4; n -= 4) {
+            w = *src++;
+            cfg_reg_addr = addr;
+            cfg_reg_data_0 = w & 0xff;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+            cfg_reg_addr = addr + 1;
+            cfg_reg_data_0 = (w >> 8) & 0xff;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+            cfg_reg_addr = addr + 2;
+            cfg_reg_data_0 = (w >> 16) & 0xff;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+            cfg_reg_addr = addr + 3;
+            cfg_reg_data_0 = w >> 24;
+            cfg_reg_ctrl = CFG_CTRL_STORE;
+            addr += 4;
+        }
+        if (n) {
+            w = *src++;
+            for (; n; n--) {
+                cfg_reg_addr = addr++;
+                cfg_reg_data_0 = w & 0xff;
+                cfg_reg_ctrl = CFG_CTRL_STORE;
+                w >>= 8;
+            }
+        }
+    }
+    return src;
+}
+
+/*
+ * wakey_verify()
+ * ----------------------------------------------------------------------------
+ * read every bank in the blob back from the configuration memory, pack
+ * the used lanes as the blob does and compare the checksum with the blob
+ * header.  Returns 0 if it matches, -1 otherwise or if the blob is not
+ * valid (nothing is read).
+ */
+int wakey_verify(const uint32_t *blob)
+{
+    const uint32_t *index = blob + WAKEY_BLOB_HEADER;
+    uint32_t sum = 0;
+    uint32_t w, addr, n, lanes, step;
+    int bits;
+
+    if (wakey_check(blob))
+        return -1;
+
+    for (uint32_t i = 0; i < blob[1]; i++) {
+        addr = WAKEY_BANK_ADDR(index[i]);
+        n = WAKEY_BANK_COUNT(index[i]);
+        lanes = WAKEY_BANK_LANES(index[i]);
+        step = 8 << wakey_lane_shift(lanes);	// payload bits per entry
+        w = 0;
+        bits = 0;
+        for (; n; n--) {
+            cfg_reg_addr = addr++;
+            cfg_reg_ctrl = CFG_CTRL_LOAD;
+            // the load takes one clock cycle to start (see cfg_load())
+            __asm__ volatile ("nop");
+            w |= (cfg_reg_data_0 & 0xff) << bits;
+            if (lanes & 0x2)
+                w |= (cfg_reg_data_1 & 0xff) << (bits + 8);
+            if (lanes & 0x4) {
+                w |= (cfg_reg_data_2 & 0xff) << (bits + 16);
+                w |= (cfg_reg_data_3 & 0xff) << (bits + 24);
+            }
+            bits += step;
+            if (bits == 32) {
+                sum = ((sum << 1) | (sum >> 31)) + w;
+                w = 0;
+                bits = 0;
+            }
+        }
+        if (bits)
+            sum = ((sum << 1) | (sum >> 31)) + w;
+    }
+    return sum == blob[3] ? 0 : -1;
+}
+
+/*
+ * wakey_load()
+ * ----------------------------------------------------------------------------
+ * load a weight blob made by util/wakey_pack.py into the configuration
+ * memory and verify it.  Returns 0 on success, -1 if the blob is not
+ * valid (nothing is stored) and -2 if the readback does not match.
+ */
+int wakey_load(const uint32_t *blob)
+{
+    const uint32_t *index = blob + WAKEY_BLOB_HEADER;
+    const uint32_t *src;
+
+    if (wakey_check(blob))
+        return -1;
+
+    src = index + blob[1];
+    for (uint32_t i = 0; i < blob[1]; i++)
+        src = wakey_store_bank(WAKEY_BANK_ADDR(index[i]), WAKEY_BANK_COUNT(index[i]),
+                               WAKEY_BANK_LANES(index[i]), src);
+
+    return wakey_verify(blob) ? -2 : 0;
+}
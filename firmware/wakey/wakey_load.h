@@ -0,0 +1,32 @@
+#ifndef WAKEY_LOAD_H
+#define WAKEY_LOAD_H
+
+#include "../defs_mpw-two-mfix.h"
+
+// Wishbone configuration interface of Wakey Wakey:  a store or load moves
+// the four byte-wide data lanes to or from the address given
+#define cfg_reg_addr   (*(volatile uint32_t*)0x30000000)
+#define cfg_reg_ctrl   (*(volatile uint32_t*)0x30000004)
+#define cfg_reg_data_0 (*(volatile uint32_t*)0x30000008)
+#define cfg_reg_data_1 (*(volatile uint32_t*)0x3000000C)
+#define cfg_reg_data_2 (*(volatile uint32_t*)0x30000010)
+#define cfg_reg_data_3 (*(volatile uint32_t*)0x30000014)
+
+#define CFG_CTRL_STORE	0x1
+#define CFG_CTRL_LOAD	0x2
+
+// Weight blob made by util/wakey_pack.py (see there for the layout)
+#define WAKEY_BLOB_MAGIC	0x31594b57
+#define WAKEY_BLOB_HEADER	4
+
+#define WAKEY_BANK_ADDR(index)	((index) & 0xffff)
+#define WAKEY_BANK_COUNT(index)	(((index) >> 16) & 0xfff)
+#define WAKEY_BANK_LANES(index)	((index) >> 28)
+
+// Blob linked in from wakey_weights.s
+extern const uint32_t wakey_weights[];
+
+int wakey_load(const uint32_t *blob);
+int wakey_verify(const uint32_t *blob);
+
+#endif // WAKEY_LOAD_H
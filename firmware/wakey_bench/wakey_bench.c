@@ -0,0 +1,152 @@
+#include "../defs_mpw-two-mfix.h"
+#include "../print_io.h"
+#include "../fmt_io.h"
+#include "../time_io.h"
+#include "../gpio_config_io.h"
+#include "../ramfunc.h"
+
+// End-to-end Wakey Wakey benchmark.  PDM clips from flash (pdm_clips.s,
+// made by util/pdm_clips.py) are played into the design one bit per PDM
+// clock:  the design drives the clock on IO[35], the bit goes out on
+// IO[36] after the falling edge and is sampled on the rising one.  Before
+// each clip the pipeline is reset through ctl_pipeline_en (LA bit 0).
+// Counter-timer 0 (the low word of the time_io timebase) timestamps the
+// end of the keyword and the wake edge on IO[37].
+
+extern const uint32_t pdm_clips[];
+
+#define PDM_CLIPS_MAGIC	0x314d4450
+#define PDM_CLIP_WORDS	5
+#define PDM_NO_EVENT	0xffffffff
+
+// reg_mprj_datah bits
+#define PDM_CLK		(1 << (35 - 32))
+#define PDM_DATA	(1 << (36 - 32))
+#define PDM_WAKE	(1 << (37 - 32))
+
+// reg_la0_data
+#define CTL_PIPELINE_EN	0x1
+
+// UART TX on 6; PDM activate input on 34; clock and wake are user outputs
+// the management side monitors; PDM data is a management output the user
+// side sees through the pad input
+static const gpio_config_t bench_pads[] = {
+    GPIO_PAD(6, 0x7ff),
+    GPIO_PAD(34, GPIO_MODE_USER_STD_INPUT_PULLUP),
+    GPIO_PAD(35, GPIO_MODE_USER_STD_OUT_MONITORED),
+    GPIO_PAD(36, GPIO_MODE_MGMT_STD_OUT_MONITORED),
+    GPIO_PAD(37, GPIO_MODE_USER_STD_OUT_MONITORED),
+};
+
+typedef struct {
+    uint32_t wake;	// bit at which wake was first seen, or PDM_NO_EVENT
+    uint32_t t_event;	// timer 0 at the event bit
+    uint32_t t_wake;	// timer 0 at the wake edge
+    uint32_t late;	// bits driven after the rising edge they were meant for
+} play_t;
+
+/*
+ * pdm_play()
+ * ----------------------------------------------------------------------------
+ * play bits PDM bits from src (LSB first) in step with the design's PDM
+ * clock.  Runs from RAM so that flash fetches do not stretch the loop.
+ */
+RAMFUNC static void pdm_play(const uint32_t *src, uint32_t bits, uint32_t event, play_t *p)
+{
+    uint32_t w = 0, pads;
+
+    p->wake = PDM_NO_EVENT;
+    p->t_event = 0;
+    p->t_wake = 0;
+    p->late = 0;
+    for (uint32_t i = 0; i < bits; i++) {
+        if (!(i & 31))
+            w = *src++;
+        while (reg_mprj_datah & PDM_CLK);
+        reg_mprj_datah = (w & 1) ? PDM_DATA : 0;
+        w >>= 1;
+
+        pads = reg_mprj_datah;
+        if (pads & PDM_CLK)
+            p->late++;
+        if (i == event)
+            p->t_event = reg_timer0_value;
+        if ((pads & PDM_WAKE) && p->wake == PDM_NO_EVENT) {
+            p->t_wake = reg_timer0_value;
+            p->wake = i;
+        }
+        while (!(reg_mprj_datah & PDM_CLK));
+    }
+}
+
+static void clip_name(char *buf, const uint32_t *clip)
+{
+    const char *s = (const char *) &clip[3];
+
+    for (int i = 0; i < 8; i++)
+        buf[i] = s[i];
+    buf[8] = 0;
+}
+
+void main()
+{
+    const uint32_t *clip;
+    play_t p;
+    char name[9];
+    uint32_t n, start, cycles, total, bits = 0, play = 0, errors = 0;
+    const char *result;
+
+    reg_uart_clkdiv = 1042;
+    reg_uart_enable = 1;
+
+    gpio_config(bench_pads, GPIO_CONFIG_LEN(bench_pads));
+    reg_mprj_datah = 0;
+
+    reg_la0_oenb = reg_la0_iena = 0xFFFFFFFF;
+    reg_la0_data = 0;
+    time_timebase_start();
+
+    print("wakey_bench\n");
+    if (pdm_clips[0] != PDM_CLIPS_MAGIC) {
+        print("no clips\n");
+        return;
+    }
+    n = pdm_clips[1];
+
+    total = reg_timer0_value;
+    clip = &pdm_clips[2];
+    for (uint32_t c = 0; c < n; c++, clip += PDM_CLIP_WORDS) {
+        // reset the pipeline
+        reg_la0_data = 0;
+        reg_la0_data = CTL_PIPELINE_EN;
+
+        start = reg_timer0_value;
+        pdm_play(&pdm_clips[clip[2]], clip[0], clip[1], &p);
+        cycles = reg_timer0_value - start;
+        bits += clip[0];
+        play += cycles;
+
+        if (clip[1] == PDM_NO_EVENT)
+            result = p.wake == PDM_NO_EVENT ? "ok" : "FALSE WAKE";
+        else if (p.wake == PDM_NO_EVENT)
+            result = "MISSED";
+        else
+            result = p.wake < clip[1] ? "EARLY" : "ok";
+        if (result[0] != 'o')
+            errors++;
+
+        clip_name(name, clip);
+        print_fmt("%-8s %6u bits %9u cycles  ", name, clip[0], cycles);
+        if (p.wake != PDM_NO_EVENT && clip[1] != PDM_NO_EVENT && p.wake >= clip[1])
+            print_fmt("latency %6u bits %7u us", p.wake - clip[1],
+                      time_cycles_to_us(p.t_wake - p.t_event));
+        else
+            print_fmt("%-29s", p.wake == PDM_NO_EVENT ? "no wake" : "wake");
+        print_fmt("  late %u  %s\n", p.late, result);
+    }
+    total = reg_timer0_value - total;
+
+    print_fmt("%u clips %u errors  pdm %u bit/s  ", n, errors, time_rate(bits, play));
+    print_fixed(time_rate(n << 10, total), 10, 3);
+    print(" clips/s\n");
+}